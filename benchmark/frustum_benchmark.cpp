@@ -0,0 +1,223 @@
+// -----------------------------------------------------------------------------
+// GL-free benchmark of the node quad vs. 2d view frustum classification.
+//
+// usage: frustum_benchmark [level] [views] [repeats]
+//
+// All quads of a tree level are classified against a number of views, once
+// with the former per node test (model space corners, point in wedge test
+// and segment intersections of the four edges with both frustum edges) and
+// once with every classify_quads_2d kernel the cpu supports. Reported are
+// the quads per second and the quads on which a kernel disagrees with the
+// scalar kernel or misses an intersection the per node test found.
+// -----------------------------------------------------------------------------
+#include <frustum_classify_2d.hpp>
+#include <intersection_2d.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+
+namespace {
+
+struct view_2d
+{
+    glm::vec2 camera;
+    glm::vec2 frustum_points[2];
+};
+
+std::vector<view_2d>
+make_views(const unsigned count)
+{
+    // the two default views of the application, more ones rotated around
+    // the tree center
+    std::vector<view_2d> views(count);
+
+    for (unsigned v = 0; v != count; ++v){
+        const float a = 0.7f * v;
+        const float s = std::sin(a);
+        const float c = std::cos(a);
+        const glm::vec2 center(0.5f);
+
+        view_2d base;
+        base.camera = (v % 2) ? glm::vec2(0.4f, 0.5f) : glm::vec2(0.2f, 0.5f);
+        base.frustum_points[0] = glm::vec2(0.4f, 0.8f);
+        base.frustum_points[1] = glm::vec2(0.7f, 0.7f);
+
+        auto rotate = [&](const glm::vec2 p){
+            const glm::vec2 d = p - center;
+            return center + glm::vec2(c * d.x - s * d.y, s * d.x + c * d.y);
+        };
+
+        views[v].camera = rotate(base.camera);
+        views[v].frustum_points[0] = rotate(base.frustum_points[0]);
+        views[v].frustum_points[1] = rotate(base.frustum_points[1]);
+    }
+
+    return views;
+}
+
+bool
+point_in_view(const view_2d& f, const glm::vec2 pos)
+{
+    const glm::vec2 c = f.camera;
+
+    glm::vec2 n1 = c - (f.frustum_points[0] + (f.frustum_points[0] - c) * 100.0f);
+    n1 = glm::vec2(-n1.y, n1.x);
+    glm::vec2 n2 = (f.frustum_points[1] + (f.frustum_points[1] - c) * 100.0f) - c;
+    n2 = glm::vec2(-n2.y, n2.x);
+
+    return glm::dot(n1, pos - c) > 0.0f && glm::dot(n2, pos - c) > 0.0f;
+}
+
+// the test QuadtreeEngine used per node and view before classify_quads_2d
+bool
+intersect_view(const view_2d& f, const glm::vec2 corners[4])
+{
+    glm::vec2 r1;
+    glm::vec2 r2;
+
+    for (unsigned e = 0; e != 2; ++e){
+        for (unsigned i = 0; i != 4; ++i){
+            if (intersect2D_2Segments(f.camera, f.frustum_points[e], corners[i], corners[(i + 1) % 4], &r1, &r2) != 0)
+                return true;
+        }
+    }
+
+    for (unsigned i = 0; i != 4; ++i){
+        if (point_in_view(f, corners[i]))
+            return true;
+    }
+    return false;
+}
+
+double
+seconds_since(const std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned level = 8;
+    unsigned view_count = 2;
+    unsigned repeats = 20;
+
+    if (argc > 1){
+        level = (unsigned)std::atoi(argv[1]);
+    }
+    if (argc > 2){
+        view_count = std::max(1, std::min(32, std::atoi(argv[2])));
+    }
+    if (argc > 3){
+        repeats = std::max(1, std::atoi(argv[3]));
+    }
+
+    // the model of the application
+    const glm::mat4 model = glm::translate(glm::vec3(0.35f, 0.15f, 0.0f)) * glm::scale(glm::vec3(0.4f, 0.6f, 1.0f));
+
+    const auto views = make_views(view_count);
+
+    std::vector<frustum_planes_2d> planes;
+    for (auto& v : views){
+        planes.push_back(make_frustum_planes_2d(v.camera, v.frustum_points[0], v.frustum_points[1], model));
+    }
+
+    const unsigned dim = 1u << level;
+    const size_t quad_count = (size_t)dim * dim;
+    const float size = 1.0f / dim;
+
+    std::vector<float> qx(quad_count);
+    std::vector<float> qy(quad_count);
+    std::vector<float> qs(quad_count, size);
+
+    for (size_t i = 0; i != quad_count; ++i){
+        qx[i] = (i % dim) * size;
+        qy[i] = (i / dim) * size;
+    }
+
+    // per node test
+    std::vector<glm::uint32> legacy(quad_count);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned r = 0; r != repeats; ++r){
+        for (size_t i = 0; i != quad_count; ++i){
+            const glm::vec2 tree_corners[4] = {
+                glm::vec2(qx[i], qy[i]),
+                glm::vec2(qx[i] + size, qy[i]),
+                glm::vec2(qx[i] + size, qy[i] + size),
+                glm::vec2(qx[i], qy[i] + size)
+            };
+
+            glm::vec2 corners[4];
+            for (unsigned c = 0; c != 4; ++c){
+                const glm::vec4 trans = model * glm::vec4(tree_corners[c], 0.0f, 1.0f);
+                corners[c] = glm::vec2(trans.x, trans.y);
+            }
+
+            glm::uint32 hit = 0;
+            for (unsigned v = 0; v != view_count; ++v){
+                hit |= glm::uint32(intersect_view(views[v], corners)) << v;
+            }
+            legacy[i] = hit;
+        }
+    }
+    const double legacy_seconds = seconds_since(start);
+
+    std::cout << "level " << level << ", " << quad_count << " quads, " << view_count << " views" << std::endl;
+    std::cout << "  test        Mquads/s   speedup   mismatches   missed" << std::endl;
+    std::cout << std::setw(8) << "per node"
+        << std::setw(14) << std::fixed << std::setprecision(2) << (quad_count * repeats) / legacy_seconds * 1e-6
+        << std::setw(10) << 1.0
+        << std::setw(13) << "-"
+        << std::setw(9) << "-"
+        << std::endl;
+
+    std::vector<glm::uint32> scalar_inside(quad_count);
+    std::vector<glm::uint32> scalar_outside(quad_count);
+    std::vector<glm::uint32> inside(quad_count);
+    std::vector<glm::uint32> outside(quad_count);
+
+    const frustum_kernel_2d kernels[] = { FRUSTUM_KERNEL_SCALAR, FRUSTUM_KERNEL_SSE4, FRUSTUM_KERNEL_AVX2 };
+
+    for (auto kernel : kernels){
+        if (!set_frustum_kernel_2d(kernel))
+            continue;
+
+        start = std::chrono::high_resolution_clock::now();
+        for (unsigned r = 0; r != repeats; ++r){
+            classify_quads_2d(planes.data(), view_count, qx.data(), qy.data(), qs.data(), quad_count,
+                              inside.data(), outside.data());
+        }
+        const double seconds = seconds_since(start);
+
+        if (kernel == FRUSTUM_KERNEL_SCALAR){
+            scalar_inside = inside;
+            scalar_outside = outside;
+        }
+
+        size_t mismatches = 0;
+        size_t missed = 0;
+        for (size_t i = 0; i != quad_count; ++i){
+            mismatches += (inside[i] != scalar_inside[i] || outside[i] != scalar_outside[i]);
+            missed += (legacy[i] & outside[i]) != 0;
+        }
+
+        std::cout << std::setw(8) << frustum_kernel_2d_name(kernel)
+            << std::setw(14) << std::fixed << std::setprecision(2) << (quad_count * repeats) / seconds * 1e-6
+            << std::setw(10) << legacy_seconds / seconds
+            << std::setw(13) << mismatches
+            << std::setw(9) << missed
+            << std::endl;
+    }
+
+    return 0;
+}
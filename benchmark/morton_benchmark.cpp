@@ -0,0 +1,220 @@
+// -----------------------------------------------------------------------------
+// GL-free benchmark of the quadtree layout Morton code conversions.
+//
+// usage: morton_benchmark [depth] [count] [repeats]
+//
+// Random node ids of a tree of the given depth are converted to positions
+// and back, once with the former quadtree_layout loops (the branchy
+// floor_log2 and one bit pair per iteration), once with the inline
+// quadtree_layout functions per node and once with every batch kernel the
+// cpu supports (decoding through quadtree_layout::node_positions, encoding
+// level codes with morton_encode_2d). Reported are the conversions per
+// second and the results that differ from the former loops, in the rows
+// former, inline and one per kernel: loop, table, magic and bmi2.
+// -----------------------------------------------------------------------------
+#include <quadtree_layout.h>
+#include <morton_2d.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef scm::data::quadtree_layout<> layout_type;
+
+glm::int32
+loop_floor_log2(glm::int32 x)
+{
+    glm::int32 pos = 0;
+
+    if (x & 0xffff0000u) { x >>= 16; pos += 16; }
+    if (x & 0x0000ff00u) { x >>= 8; pos += 8; }
+    if (x & 0x000000f0u) { x >>= 4; pos += 4; }
+    if (x & 0x0000000cu) { x >>= 2; pos += 2; }
+    if (x & 0x00000002u) { pos += 1; }
+
+    return ((x == 0) ? (-1) : pos);
+}
+
+glm::uvec2
+loop_node_position(const layout_type& layout, glm::uint32 node_index)
+{
+    const unsigned node_level = loop_floor_log2(node_index * 3u + 1u) / 2u;
+    node_index -= (node_level == 0 ? 0 : layout.total_node_count(node_level - 1));
+
+    glm::uvec2 tmp(0u, 0u);
+
+    for (unsigned i = 0; i < 16; ++i) {
+        tmp.x |= glm::uint32(node_index & 1) << i;
+        tmp.y |= glm::uint32(node_index & 2) << i;
+
+        node_index >>= 2;
+    }
+    tmp.y >>= 1;
+
+    return tmp;
+}
+
+glm::uint32
+loop_node_index(const layout_type& layout, const glm::uvec2& node_position, const unsigned level)
+{
+    glm::uint32 tmp = 0;
+
+    for (unsigned i = 0; i < 16; ++i) {
+        const glm::uint32 bit = (1u << i);
+
+        tmp |= (node_position.x & bit) << (i);
+        tmp |= (node_position.y & bit) << (i + 1);
+    }
+
+    return (tmp + (level == 0 ? 0 : layout.total_node_count(level - 1)));
+}
+
+double
+seconds_since(const std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void
+print_row(const char* name, const size_t conversions, const double decode_seconds, const double encode_seconds,
+          const size_t errors)
+{
+    std::cout << std::setw(8) << name
+        << std::setw(16) << std::fixed << std::setprecision(1) << conversions / decode_seconds * 1e-6
+        << std::setw(16) << conversions / encode_seconds * 1e-6
+        << std::setw(9) << errors
+        << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned depth = 12;
+    size_t count = 1 << 20;
+    unsigned repeats = 10;
+
+    if (argc > 1){
+        depth = std::min(15, std::max(0, std::atoi(argv[1])));
+    }
+    if (argc > 2){
+        count = (size_t)std::max(1, std::atoi(argv[2]));
+    }
+    if (argc > 3){
+        repeats = std::max(1, std::atoi(argv[3]));
+    }
+
+    const layout_type layout;
+
+    // ids of all levels, positions and levels of the former loops as reference
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<glm::uint32> node_dist(0, layout.total_node_count(depth) - 1);
+
+    std::vector<glm::uint32> ids(count);
+    std::vector<unsigned> levels(count);
+    std::vector<glm::uvec2> reference(count);
+
+    for (size_t i = 0; i != count; ++i){
+        ids[i] = node_dist(rng);
+        levels[i] = loop_floor_log2(ids[i] * 3u + 1u) / 2u;
+        reference[i] = loop_node_position(layout, ids[i]);
+    }
+
+    std::vector<glm::uvec2> positions(count);
+    std::vector<glm::uint32> codes(count);
+    const size_t conversions = count * repeats;
+
+    std::cout << "depth " << depth << ", " << count << " node ids" << std::endl;
+    std::cout << "  path    decode [M/s]    encode [M/s]   errors" << std::endl;
+
+    // former loops per node
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned r = 0; r != repeats; ++r){
+        for (size_t i = 0; i != count; ++i){
+            positions[i] = loop_node_position(layout, ids[i]);
+        }
+    }
+    double decode_seconds = seconds_since(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (unsigned r = 0; r != repeats; ++r){
+        for (size_t i = 0; i != count; ++i){
+            codes[i] = loop_node_index(layout, reference[i], levels[i]);
+        }
+    }
+    double encode_seconds = seconds_since(start);
+
+    size_t errors = 0;
+    for (size_t i = 0; i != count; ++i){
+        errors += (codes[i] != ids[i]);
+    }
+    print_row("former", conversions, decode_seconds, encode_seconds, errors);
+
+    // inline layout functions per node
+    start = std::chrono::high_resolution_clock::now();
+    for (unsigned r = 0; r != repeats; ++r){
+        for (size_t i = 0; i != count; ++i){
+            positions[i] = layout.node_position(ids[i]);
+        }
+    }
+    decode_seconds = seconds_since(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (unsigned r = 0; r != repeats; ++r){
+        for (size_t i = 0; i != count; ++i){
+            codes[i] = layout.node_index(reference[i], layout.level_index(ids[i]));
+        }
+    }
+    encode_seconds = seconds_since(start);
+
+    errors = 0;
+    for (size_t i = 0; i != count; ++i){
+        errors += (positions[i] != reference[i]) || (codes[i] != ids[i]);
+    }
+    print_row("inline", conversions, decode_seconds, encode_seconds, errors);
+
+    // batch kernels, node ids to positions and positions to level codes
+    std::vector<glm::uvec2> level_positions(reference);
+    std::vector<glm::uint32> level_codes(count);
+    for (size_t i = 0; i != count; ++i){
+        level_codes[i] = ids[i] - (levels[i] == 0 ? 0 : layout.total_node_count(levels[i] - 1));
+    }
+
+    const morton_kernel_2d kernels[] = { MORTON_KERNEL_LOOP, MORTON_KERNEL_TABLE, MORTON_KERNEL_MAGIC, MORTON_KERNEL_BMI2 };
+    const morton_kernel_2d active = active_morton_kernel_2d();
+
+    for (auto kernel : kernels){
+        if (!set_morton_kernel_2d(kernel))
+            continue;
+
+        start = std::chrono::high_resolution_clock::now();
+        for (unsigned r = 0; r != repeats; ++r){
+            layout.node_positions(ids.data(), positions.data(), count);
+        }
+        decode_seconds = seconds_since(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        for (unsigned r = 0; r != repeats; ++r){
+            morton_encode_2d(level_positions.data(), codes.data(), count);
+        }
+        encode_seconds = seconds_since(start);
+
+        errors = 0;
+        for (size_t i = 0; i != count; ++i){
+            errors += (positions[i] != reference[i]) || (codes[i] != level_codes[i]);
+        }
+
+        print_row(morton_kernel_2d_name(kernel), conversions, decode_seconds, encode_seconds, errors);
+    }
+
+    set_morton_kernel_2d(active);
+    std::cout << "startup kernel: " << morton_kernel_2d_name(active) << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,257 @@
+// -----------------------------------------------------------------------------
+// GL-free benchmark of the quadtree refinement engine.
+//
+// usage: quadtree_benchmark [frames] [budget ...] [-t milliseconds] [-j threads] [-i] [-r readers]
+//
+//   frames          updates per phase, default 20
+//   budget          tree budgets to run, default 2000 100000 1000000
+//   -t ms           frame time budget of update(), default none
+//   -j threads      threads of the evaluation pool, default one per hardware
+//                   thread, 1 evaluates on the calling thread only
+//   -i              follow the ideal tree of the background solver
+//   -r readers      threads looking up leafs in read sections meanwhile
+//
+// For every budget the tree is filled breadth first, then updated for the
+// given frames with a slowly moving camera and as many with a static one.
+// Columns:
+//
+//   budget          tree budget
+//   depth           depth the tree was filled to
+//   nodes           nodes in use after the moving camera
+//   B/node          bytes of node storage per node
+//   memory KiB      memory of the tree
+//   scan [us]       one pass over all leafs, as priority updates and vbo
+//                   upload do it
+//   update [us]     mean update() time, moving camera
+//   max [us]        longest update() time, moving camera
+//   evals           mean re-evaluated priorities per update, moving camera
+//   allocs          heap allocations of all frames, moving camera
+//   static [us]     mean update() time, static camera
+//   evals           mean re-evaluated priorities per update, static camera
+//   allocs          heap allocations of all frames, static camera
+//   checksum        sum of the node ids over the leaf scans, compares runs
+//
+// allocs counts all heap allocations with
+// RESTRICTED_QUADTREE_COUNT_ALLOCATIONS, otherwise only the blocks of the
+// frame arena. -i adds the distance to the ideal tree after each phase and
+// the time of the last solve, -r the leaf lookups per update and the most
+// blocks held back for the readers. The exit status is 1 if a frame with
+// the static camera allocated, unless -i is given.
+// -----------------------------------------------------------------------------
+#include <QuadtreeEngine.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+
+namespace {
+
+unsigned
+depth_for_budget(const unsigned budget)
+{
+    // smallest depth whose uniform tree holds the budget, at least the
+    // depth the application uses
+    unsigned depth = 7;
+    while (depth < 16 && (1u << (2 * depth)) < budget){
+        ++depth;
+    }
+    return depth;
+}
+
+std::vector<QuadtreeEngine::frustrum_2d>
+make_views(const float t)
+{
+    // the two default views of the application, the first one circling
+    std::vector<QuadtreeEngine::frustrum_2d> views(2);
+
+    views[0].m_camera_point = glm::vec2(0.2f + 0.1f * std::sin(t), 0.5f + 0.1f * std::cos(t));
+    views[0].m_frustrum_points[0] = glm::vec2(0.4f, 0.8f);
+    views[0].m_frustrum_points[1] = glm::vec2(0.7f, 0.7f);
+
+    views[1].m_camera_point = glm::vec2(0.4f, 0.5f);
+    views[1].m_frustrum_points[0] = glm::vec2(0.4f, 0.8f);
+    views[1].m_frustrum_points[1] = glm::vec2(0.7f, 0.7f);
+
+    return views;
+}
+
+bool
+run(const unsigned budget, const unsigned frames, const float frame_time_budget, thread_pool& pool, const bool ideal,
+    const unsigned readers)
+{
+    const unsigned depth = depth_for_budget(budget);
+
+    QuadtreeEngine engine(budget, depth);
+    engine.set_thread_pool(&pool);
+    engine.set_frame_time_budget(frame_time_budget);
+    engine.set_model(glm::translate(glm::vec3(0.35f, 0.15f, 0.0f)) * glm::scale(glm::vec3(0.4f, 0.6f, 1.0f)));
+    engine.split_to_depth(depth);
+    engine.set_ideal_solver(ideal);
+
+    // leaf scan, the access pattern of priority updates and vbo upload.
+    // The priorities are still -depth, the node ids keep the sum from
+    // cancelling out.
+    const unsigned scans = 10;
+    double checksum = 0.0;
+    auto scan_start = std::chrono::high_resolution_clock::now();
+    for (unsigned s = 0; s != scans; ++s){
+        auto& leafs = engine.get_leaf_nodes();
+        for (auto& l : leafs){
+            checksum += l->priority + (double)l->depth + (double)l->node_id;
+        }
+    }
+    auto scan_end = std::chrono::high_resolution_clock::now();
+    auto scan_us = std::chrono::duration_cast<std::chrono::microseconds>(scan_end - scan_start).count() / scans;
+
+    // leaf lookups at scattered cells, a short read section per batch
+    std::atomic<bool> stop_readers(false);
+    std::atomic<size_t> lookups(0);
+    std::vector<std::thread> reader_threads;
+    for (unsigned r = 0; r != readers; ++r){
+        reader_threads.push_back(std::thread([&engine, &stop_readers, &lookups, depth, r]{
+            size_t count = 0;
+            unsigned cell = r * 7919u;
+            while (!stop_readers){
+                QuadtreeEngine::read_section section(engine);
+                for (unsigned q = 0; q != 64; ++q){
+                    unsigned leaf_depth;
+                    cell = cell * 1664525u + 1013904223u;
+                    section.find_leaf(glm::uvec2(cell >> (32 - depth), (cell >> 8) & ((1u << depth) - 1)), leaf_depth);
+                }
+                count += 64;
+            }
+            lookups += count;
+        }));
+    }
+    size_t max_retired = 0;
+
+    size_t update_us = 0;
+    size_t max_update_us = 0;
+    size_t updates = 0;
+    size_t allocations = 0;
+    QuadtreeEngine::TreeInfo info = engine.get_tree_info();
+    for (unsigned f = 0; f != frames; ++f){
+        info = engine.update(make_views(f * 0.01f));
+        update_us += info.time_current_tree_update;
+        max_update_us = std::max(max_update_us, info.time_current_tree_update);
+        updates += info.priority_updates;
+        allocations += info.heap_allocations;
+        max_retired = std::max(max_retired, info.retired_blocks);
+    }
+
+    size_t static_us = 0;
+    size_t static_updates = 0;
+    size_t static_allocations = 0;
+    QuadtreeEngine::TreeInfo static_info = info;
+    for (unsigned f = 0; f != frames; ++f){
+        static_info = engine.update(make_views(frames * 0.01f));
+        static_us += static_info.time_current_tree_update;
+        static_updates += static_info.priority_updates;
+        static_allocations += static_info.heap_allocations;
+        max_retired = std::max(max_retired, static_info.retired_blocks);
+    }
+
+    stop_readers = true;
+    for (auto& t : reader_threads){
+        t.join();
+    }
+
+    std::cout << std::setw(8) << budget
+        << std::setw(7) << depth
+        << std::setw(9) << info.used_budget
+        << std::setw(8) << QuadtreeEngine::q_node_pool::bytes_per_node()
+        << std::setw(12) << info.memory_usage / 1024
+        << std::setw(12) << scan_us
+        << std::setw(14) << (frames ? update_us / frames : 0)
+        << std::setw(10) << max_update_us
+        << std::setw(9) << (frames ? updates / frames : 0)
+        << std::setw(8) << allocations
+        << std::setw(14) << (frames ? static_us / frames : 0)
+        << std::setw(9) << (frames ? static_updates / frames : 0)
+        << std::setw(8) << static_allocations
+        << "   checksum " << (unsigned long long)checksum;
+    if (ideal){
+        std::cout << "   ideal distance " << info.ideal_distance << " " << static_info.ideal_distance
+            << " solve [us] " << static_info.time_new_tree_update;
+    }
+    if (readers){
+        std::cout << "   lookups " << (frames ? lookups / (2 * frames) : 0) << " retired " << max_retired;
+    }
+    std::cout << std::endl;
+
+    // all storage of a frame is reserved once the tree is filled, the
+    // background solver allocates on a thread of its own
+    if (static_allocations && !ideal){
+        std::cerr << "budget " << budget << ": " << static_allocations << " heap allocations with a static camera" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned frames = 20;
+    float frame_time_budget = 0.0f;
+    unsigned threads = 0;
+    bool ideal = false;
+    unsigned readers = 0;
+    std::vector<unsigned> budgets;
+
+    for (int a = 1; a < argc; ++a){
+        if (std::string(argv[a]) == "-t" && a + 1 < argc){
+            frame_time_budget = (float)std::atof(argv[++a]);
+        }
+        else if (std::string(argv[a]) == "-j" && a + 1 < argc){
+            threads = (unsigned)std::max(1, std::atoi(argv[++a]));
+        }
+        else if (std::string(argv[a]) == "-i"){
+            ideal = true;
+        }
+        else if (std::string(argv[a]) == "-r" && a + 1 < argc){
+            readers = (unsigned)std::max(0, std::atoi(argv[++a]));
+        }
+        else if (a == 1){
+            frames = (unsigned)std::atoi(argv[a]);
+        }
+        else {
+            budgets.push_back((unsigned)std::atoi(argv[a]));
+        }
+    }
+    if (budgets.empty()){
+        budgets.push_back(2000);
+        budgets.push_back(100000);
+        budgets.push_back(1000000);
+    }
+
+    std::unique_ptr<thread_pool> own_pool;
+    if (threads){
+        own_pool.reset(new thread_pool(threads));
+    }
+    thread_pool& pool = own_pool ? *own_pool : thread_pool::shared();
+
+    std::cout << "threads: " << pool.size() << std::endl;
+    if (frame_time_budget > 0.0f){
+        std::cout << "frame time budget: " << frame_time_budget << " ms" << std::endl;
+    }
+    std::cout << "  budget  depth    nodes  B/node   memory KiB   scan [us]   update [us]  max [us]    evals  allocs   static [us]    evals  allocs" << std::endl;
+
+    bool allocation_free = true;
+    for (auto b : budgets){
+        allocation_free &= run(b, frames, frame_time_budget, pool, ideal, readers);
+    }
+
+    return allocation_free ? 0 : 1;
+}
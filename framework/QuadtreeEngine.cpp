@@ -0,0 +1,3146 @@
+#include "QuadtreeEngine.hpp"
+
+#include <chrono>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+
+namespace {
+
+// views in tree space, all the ideal tree depends on besides the budget
+bool
+same_views(const std::vector<QuadtreeEngine::frustrum_2d>& lhs, const std::vector<QuadtreeEngine::frustrum_2d>& rhs)
+{
+    if (lhs.size() != rhs.size())
+        return false;
+
+    for (size_t i = 0; i != lhs.size(); ++i){
+        if (lhs[i].m_camera_point_trans != rhs[i].m_camera_point_trans
+            || lhs[i].m_frustrum_points_trans[0] != rhs[i].m_frustrum_points_trans[0]
+            || lhs[i].m_frustrum_points_trans[1] != rhs[i].m_frustrum_points_trans[1])
+            return false;
+    }
+    return true;
+}
+
+}
+
+QuadtreeEngine::QuadtreeEngine(const unsigned budget, const unsigned max_depth)
+{
+    m_treeInfo.min_prio = 9999.99;
+    m_treeInfo.max_prio = -9999.99;
+    m_treeInfo.min_importance = 0.0;
+    m_treeInfo.max_importance = 0.0;
+    m_treeInfo.min_error = 0.0;
+    m_treeInfo.max_error = 0.0;
+    m_treeInfo.used_ideal_budget = 0;
+    m_treeInfo.memory_usage = 0;
+    m_treeInfo.pool_blocks_used = 0;
+    m_treeInfo.pool_blocks_capacity = 0;
+    m_treeInfo.puffer_size = 0.0;
+    m_treeInfo.time_new_tree_update = 0;
+    m_treeInfo.time_current_tree_update = 0;
+    m_treeInfo.priority_updates = 0;
+    m_treeInfo.forced_splits = 0;
+    m_treeInfo.max_forced_splits = 0;
+    m_treeInfo.planned_splits = 0;
+    m_treeInfo.applied_splits = 0;
+    m_treeInfo.split_sets = 0;
+    m_treeInfo.pending_plan_steps = 0;
+    m_treeInfo.deferred_evaluations = 0;
+    m_treeInfo.churned_splits = 0;
+    m_treeInfo.collapse_cache_hits = 0;
+    m_treeInfo.collapse_cache_misses = 0;
+    m_treeInfo.collapse_cache_blocks = 0;
+    m_treeInfo.ideal_distance = 0;
+    m_treeInfo.ideal_age = 0;
+    m_treeInfo.retired_blocks = 0;
+    m_treeInfo.heap_allocations = 0;
+    m_treeInfo.frame_arena_bytes = 0;
+
+    m_view_motion = 0.0f;
+    m_camera_motion = 0.0f;
+    m_priority_tolerance = 0.001f;
+    m_priorities_outdated = true;
+    m_frustum_frame = 1;
+    m_mark_epoch = 1;
+
+    m_frame_time_budget = 0.0f;
+    m_plan_step = 0;
+    m_evaluate_cursor = 0;
+
+    m_hysteresis_band = HYSTERESIS_BAND;
+    m_residency_frames = HYSTERESIS_RESIDENCY;
+    m_churn_frames = CHURN_FRAMES;
+    m_frame = 1;
+
+    m_tree_ideal = nullptr;
+    m_ideal_frame = 0;
+    m_ideal_views_frame = 0;
+    m_tree_ideal_ready = nullptr;
+    m_ideal_ready_frame = 0;
+    m_ideal_ready_time = 0;
+    m_ideal_stop = false;
+    m_tree_ideal_build = nullptr;
+
+    set_thread_pool(&thread_pool::shared());
+
+    m_tree_current = new q_tree();
+
+    m_tree_current->budget = budget;
+    m_tree_current->budget_filled = 0;
+    m_tree_current->frame_budget = 20;
+    m_tree_current->max_depth = max_depth;
+    m_tree_current->collapse_cache.reserve(COLLAPSE_CACHE_BLOCKS);
+
+    reserve_node_pool(m_tree_current);
+
+    m_tree_current->root_node = m_tree_current->node_pool.allocate_block();
+    m_tree_current->root_node->node_id = 0;
+    m_tree_current->root_node->leaf = true;
+    m_tree_current->root_node->depth = 0;
+    m_tree_current->root_node->priority = 0.0;
+    m_tree_current->root_node->error = 0.0;
+
+    m_tree_current->root_node->tree = m_tree_current;
+    m_tree_current->insert_leaf(m_tree_current->root_node);
+
+    size_t max_nodes_finest_level = q_layout.total_node_count_level(m_tree_current->max_depth);
+    m_tree_resolution = (unsigned)glm::sqrt((float)max_nodes_finest_level);
+    m_visualization = false;
+
+    m_treeInfo.max_budget = m_tree_current->budget;
+    m_treeInfo.used_budget = 0;
+    m_treeInfo.max_depth = m_tree_current->max_depth;
+
+    m_treeInfo.page_dim = glm::uvec2(256, 256);
+    m_treeInfo.ref_dim = glm::uvec2(2560, 2560);
+
+    m_treeInfo.global_error = (float)m_treeInfo.ref_dim.x / m_treeInfo.page_dim.x + (float)m_treeInfo.ref_dim.y / m_treeInfo.page_dim.y;
+    m_treeInfo.global_error_difference = (float)m_treeInfo.ref_dim.x / m_treeInfo.page_dim.x + (float)m_treeInfo.ref_dim.y / m_treeInfo.page_dim.y;
+
+    ///////////////////////////////////////////////
+    auto n = m_tree_current->root_node;
+    split_node(n);
+    n = n->child_node[0];
+    split_node(n);
+    n = n->child_node[0];
+    split_node(n);
+    n = n->child_node[0];
+    split_node(n);
+
+    ///////////////////////////////////////////////
+}
+
+QuadtreeEngine::~QuadtreeEngine()
+{
+    set_ideal_solver(false);
+
+    cleanup_container.clear();
+    delete_tree(m_tree_current);
+}
+
+void
+QuadtreeEngine::delete_tree(QuadtreeEngine::q_tree_ptr tree){
+    // all nodes live in the node pool of the tree
+    delete tree;
+}
+
+void
+QuadtreeEngine::reserve_node_pool(QuadtreeEngine::q_tree_ptr tree){
+    // budget/CHILDREN sibling blocks plus the root block, the blocks
+    // collapsed during one frame, which are only given back at its end, and
+    // those in the collapse cache
+    auto budget_blocks = tree->budget / CHILDREN + 2;
+    tree->node_pool.reserve(budget_blocks + std::min(tree->frame_budget, budget_blocks) + tree->collapse_cache.capacity());
+    tree->leaf_table.reserve(tree->budget + CHILDREN);
+
+    // every parent of leafs may be collapsible, the queues of a frame then
+    // never grow
+    tree->collapsible_heap.reserve(budget_blocks);
+    m_split_nodes.reserve(std::min(tree->frame_budget, budget_blocks));
+}
+
+void
+QuadtreeEngine::q_node::reset(){
+    updated_priority = 0.0;
+    parent = nullptr;
+    tree = nullptr;
+    valid = true;
+    leaf_index = invalid_index;
+    collapsible_index = invalid_index;
+    heap_index = invalid_index;
+    cache_index = invalid_index;
+    valid_view_motion = -1.0f;
+    valid_camera_motion = -1.0f;
+    frustum_frame = 0;
+    frustum_inside = 0;
+    frustum_outside = 0;
+    changed_frame = 0;
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+        child_node[c] = nullptr;
+    }
+
+    // links in the pool are set up once it assigned the slot
+    if (pool){
+        for (unsigned n = 0; n != NEIGHBORS; ++n){
+            neighbor_node(n) = nullptr;
+        }
+    }
+
+    node_id = 0;
+    leaf = false;
+    depth = 0;
+    importance = 0.0;
+    error = 0.0;
+    priority = 0.0;
+
+    checked_mark = 0;
+    plan_mark = 0;
+}
+
+QuadtreeEngine::q_node_pool::q_node_pool()
+: m_slab_blocks(0),
+m_capacity(0),
+m_blocks_used(0)
+{
+}
+
+QuadtreeEngine::q_node_pool::~q_node_pool()
+{
+    for (auto& slab : m_slabs){
+        delete[] slab;
+    }
+}
+
+void
+QuadtreeEngine::q_node_pool::reserve(const size_t block_count)
+{
+    if (block_count > m_capacity){
+        add_slab(block_count - m_capacity);
+    }
+    m_slab_blocks = std::max(m_slab_blocks, block_count);
+}
+
+void
+QuadtreeEngine::q_node_pool::add_slab(const size_t block_count)
+{
+    q_node_ptr slab = new q_node[block_count * CHILDREN];
+    m_slabs.push_back(slab);
+
+    glm::uint32 first_slot = slot_count();
+    size_t slots = (m_capacity + block_count) * CHILDREN;
+
+    m_neighbor_node.resize(slots * NEIGHBORS, nullptr);
+
+    for (size_t i = 0; i != block_count * CHILDREN; ++i){
+        slab[i].pool = this;
+        slab[i].slot = first_slot + (glm::uint32)i;
+    }
+
+    m_free_blocks.reserve(m_free_blocks.size() + block_count);
+
+    // push in reverse so blocks are handed out in address order
+    for (size_t b = block_count; b != 0; --b){
+        m_free_blocks.push_back(slab + (b - 1) * CHILDREN);
+    }
+
+    m_capacity += block_count;
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::q_node_pool::allocate_block()
+{
+    if (m_free_blocks.empty()){
+        add_slab(std::max(m_slab_blocks, (size_t)1));
+    }
+
+    q_node_ptr block = m_free_blocks.back();
+    m_free_blocks.pop_back();
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+        block[c].reset();
+    }
+
+    ++m_blocks_used;
+
+    return block;
+}
+
+void
+QuadtreeEngine::q_node_pool::free_block(QuadtreeEngine::q_node_ptr block)
+{
+    assert(block);
+    assert(m_blocks_used > 0);
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+        block[c].leaf = false;
+    }
+
+    m_free_blocks.push_back(block);
+    --m_blocks_used;
+}
+
+size_t
+QuadtreeEngine::q_node_pool::bytes_per_node()
+{
+    return sizeof(q_node) + NEIGHBORS * sizeof(q_node_ptr);
+}
+
+QuadtreeEngine::q_leaf_table::q_leaf_table()
+: m_size(0),
+m_shift(sizeof(size_t) * 8)
+{
+}
+
+void
+QuadtreeEngine::q_leaf_table::reserve(const size_t count)
+{
+    // at most half full
+    size_t capacity = 16;
+    while (capacity < 2 * count)
+        capacity *= 2;
+
+    if (capacity > m_entries.size())
+        rehash(capacity);
+}
+
+void
+QuadtreeEngine::q_leaf_table::clear()
+{
+    for (auto& e : m_entries){
+        e.node = nullptr;
+    }
+    m_size = 0;
+}
+
+size_t
+QuadtreeEngine::q_leaf_table::bucket(const QuadtreeEngine::index_type node_id) const
+{
+    // fibonacci hashing, the top bits spread the consecutive sibling ids
+    return (size_t)(((glm::uint64)node_id * 0x9e3779b97f4a7c15ull) >> m_shift);
+}
+
+void
+QuadtreeEngine::q_leaf_table::rehash(const size_t capacity)
+{
+    std::vector<entry> entries(capacity);
+    for (auto& e : entries){
+        e.node = nullptr;
+    }
+    entries.swap(m_entries);
+
+    m_shift = 64;
+    for (size_t c = capacity; c > 1; c >>= 1){
+        --m_shift;
+    }
+    m_size = 0;
+
+    for (auto& e : entries){
+        if (e.node)
+            insert(e.node);
+    }
+}
+
+void
+QuadtreeEngine::q_leaf_table::insert(QuadtreeEngine::q_node_ptr n)
+{
+    if (2 * (m_size + 1) > m_entries.size())
+        rehash(std::max<size_t>(16, 2 * m_entries.size()));
+
+    const size_t mask = m_entries.size() - 1;
+    const index_type node_id = n->node_id;
+
+    for (size_t i = bucket(node_id);; i = (i + 1) & mask){
+        if (m_entries[i].node == nullptr){
+            m_entries[i].node_id = node_id;
+            m_entries[i].node = n;
+            ++m_size;
+            return;
+        }
+        assert(m_entries[i].node_id != node_id);
+    }
+}
+
+void
+QuadtreeEngine::q_leaf_table::erase(const QuadtreeEngine::q_node_ptr n)
+{
+    const size_t mask = m_entries.size() - 1;
+    const index_type node_id = n->node_id;
+
+    size_t i = bucket(node_id);
+    while (m_entries[i].node != n){
+        assert(m_entries[i].node != nullptr);
+        i = (i + 1) & mask;
+    }
+
+    // shift back the following entries that probed past the hole
+    for (size_t j = (i + 1) & mask; m_entries[j].node != nullptr; j = (j + 1) & mask){
+        const size_t home = bucket(m_entries[j].node_id);
+        if (((j - home) & mask) >= ((j - i) & mask)){
+            m_entries[i] = m_entries[j];
+            i = j;
+        }
+    }
+
+    m_entries[i].node = nullptr;
+    --m_size;
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::q_leaf_table::find(const QuadtreeEngine::index_type node_id) const
+{
+    if (m_entries.empty())
+        return nullptr;
+
+    const size_t mask = m_entries.size() - 1;
+
+    for (size_t i = bucket(node_id); m_entries[i].node != nullptr; i = (i + 1) & mask){
+        if (m_entries[i].node_id == node_id)
+            return m_entries[i].node;
+    }
+    return nullptr;
+}
+
+void
+QuadtreeEngine::q_node_heap::build(const QuadtreeEngine::q_node_ptr* nodes, const size_t count)
+{
+    clear();
+    m_entries.reserve(count);
+
+    for (size_t i = 0; i != count; ++i){
+        auto n = nodes[i];
+        entry e = { key(n), n };
+        n->*m_index = (glm::uint32)m_entries.size();
+        m_entries.push_back(e);
+    }
+
+    if (m_entries.empty())
+        return;
+
+    // sift down every inner entry, last parent first
+    for (size_t i = (m_entries.size() - 1) / ARITY + 1; i != 0; --i){
+        sift_down(i - 1);
+    }
+}
+
+QuadtreeEngine::q_collapse_cache::q_collapse_cache()
+: m_size(0),
+m_oldest(q_node::invalid_index),
+m_newest(q_node::invalid_index),
+m_free(q_node::invalid_index)
+{
+}
+
+void
+QuadtreeEngine::q_collapse_cache::reserve(const size_t capacity)
+{
+    m_entries.assign(capacity, entry());
+
+    for (size_t i = 0; i != capacity; ++i){
+        m_entries[i].next = (i + 1 != capacity) ? (glm::uint32)(i + 1) : q_node::invalid_index;
+    }
+
+    m_size = 0;
+    m_oldest = q_node::invalid_index;
+    m_newest = q_node::invalid_index;
+    m_free = capacity ? 0 : q_node::invalid_index;
+}
+
+void
+QuadtreeEngine::q_collapse_cache::push(QuadtreeEngine::q_node_ptr n, QuadtreeEngine::q_node_ptr block)
+{
+    assert(!full() && !contains(n));
+
+    auto i = m_free;
+    auto& e = m_entries[i];
+    m_free = e.next;
+
+    e.node = n;
+    e.block = block;
+    e.prev = m_newest;
+    e.next = q_node::invalid_index;
+
+    if (m_newest != q_node::invalid_index)
+        m_entries[m_newest].next = i;
+    else
+        m_oldest = i;
+    m_newest = i;
+
+    n->cache_index = i;
+    ++m_size;
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::q_collapse_cache::take(QuadtreeEngine::q_node_ptr n)
+{
+    assert(contains(n));
+
+    auto i = n->cache_index;
+    auto& e = m_entries[i];
+
+    if (e.prev != q_node::invalid_index)
+        m_entries[e.prev].next = e.next;
+    else
+        m_oldest = e.next;
+
+    if (e.next != q_node::invalid_index)
+        m_entries[e.next].prev = e.prev;
+    else
+        m_newest = e.prev;
+
+    auto block = e.block;
+    e.node = nullptr;
+    e.block = nullptr;
+    e.next = m_free;
+    m_free = i;
+
+    n->cache_index = q_node::invalid_index;
+    --m_size;
+
+    return block;
+}
+
+void
+QuadtreeEngine::q_node_heap::clear()
+{
+    for (auto& e : m_entries){
+        e.node->*m_index = q_node::invalid_index;
+    }
+    m_entries.clear();
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::q_node_heap::pop()
+{
+    assert(!m_entries.empty());
+
+    q_node_ptr n = m_entries.front().node;
+    erase(n);
+    return n;
+}
+
+void
+QuadtreeEngine::q_node_heap::push(QuadtreeEngine::q_node_ptr n)
+{
+    assert(!contains(n));
+
+    entry e = { key(n), n };
+    m_entries.push_back(e);
+    n->*m_index = (glm::uint32)(m_entries.size() - 1);
+    sift_up(m_entries.size() - 1);
+}
+
+void
+QuadtreeEngine::q_node_heap::erase(QuadtreeEngine::q_node_ptr n)
+{
+    assert(contains(n));
+
+    size_t i = n->*m_index;
+    n->*m_index = q_node::invalid_index;
+
+    entry last = m_entries.back();
+    m_entries.pop_back();
+
+    if (i == m_entries.size())
+        return;
+
+    place(i, last);
+    sift_up(i);
+    sift_down(last.node->*m_index);
+}
+
+void
+QuadtreeEngine::q_node_heap::update(QuadtreeEngine::q_node_ptr n)
+{
+    assert(contains(n));
+
+    size_t i = n->*m_index;
+    float old_key = m_entries[i].key;
+    m_entries[i].key = key(n);
+
+    if (m_entries[i].key > old_key)
+        sift_up(i);
+    else
+        sift_down(i);
+}
+
+void
+QuadtreeEngine::q_node_heap::sift_up(size_t i)
+{
+    entry e = m_entries[i];
+
+    while (i != 0){
+        size_t parent = (i - 1) / ARITY;
+        if (!(m_entries[parent].key < e.key))
+            break;
+        place(i, m_entries[parent]);
+        i = parent;
+    }
+    place(i, e);
+}
+
+void
+QuadtreeEngine::q_node_heap::sift_down(size_t i)
+{
+    entry e = m_entries[i];
+    size_t count = m_entries.size();
+
+    for (;;){
+        size_t first = i * ARITY + 1;
+        if (first >= count)
+            break;
+
+        size_t last = std::min(first + ARITY, count);
+        size_t best = first;
+        for (size_t c = first + 1; c < last; ++c){
+            if (m_entries[best].key < m_entries[c].key)
+                best = c;
+        }
+
+        if (!(e.key < m_entries[best].key))
+            break;
+        place(i, m_entries[best]);
+        i = best;
+    }
+    place(i, e);
+}
+
+void
+QuadtreeEngine::q_node_heap::place(const size_t i, const QuadtreeEngine::q_node_heap::entry& e)
+{
+    m_entries[i] = e;
+    e.node->*m_index = (glm::uint32)i;
+}
+
+void
+QuadtreeEngine::set_model(const glm::mat4& model)
+{
+    m_model = model;
+    m_model_inverse = glm::inverse(model);
+    m_priorities_outdated = true;
+    update_frustum_planes();
+}
+
+void
+QuadtreeEngine::set_priority_tolerance(const float tolerance)
+{
+    m_priority_tolerance = std::max(tolerance, 0.0f);
+    m_priorities_outdated = true;
+}
+
+QuadtreeEngine::TreeInfo
+QuadtreeEngine::update(const std::vector<QuadtreeEngine::frustrum_2d>& views)
+{
+    auto time_start = std::chrono::high_resolution_clock::now();
+    auto allocations_start = heap_allocation_count();
+
+    // evaluations get the first half of the budget, refinement the rest
+    auto frame_time = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+        std::chrono::duration<float, std::milli>(m_frame_time_budget));
+    m_evaluation_deadline = time_start + frame_time / 2;
+    m_frame_deadline = time_start + frame_time;
+
+    if (++m_frame == 0)
+        m_frame = 1;
+    m_treeInfo.churned_splits = 0;
+    m_treeInfo.split_sets = 0;
+    m_treeInfo.collapse_cache_hits = 0;
+    m_treeInfo.collapse_cache_misses = 0;
+
+    // both vectors keep their storage from frame to frame
+    m_previous_frustrum_2d_vec.swap(m_frustrum_2d_vec);
+    m_frustrum_2d_vec = views;
+
+    assert(m_frustrum_2d_vec.size() <= MAX_FRUSTUMS);
+
+    for (auto& f : m_frustrum_2d_vec) {
+        glm::vec4 camera_trans = m_model_inverse * glm::vec4(f.m_camera_point, 0.0f, 1.0f);
+        f.m_camera_point_trans = glm::vec2(camera_trans.x, camera_trans.y);
+
+        m_treeInfo.ref_pos = f.m_camera_point;
+        m_treeInfo.ref_pos_trans = f.m_camera_point_trans;
+
+        auto frus1trans = (m_model_inverse * glm::vec4(f.m_frustrum_points[0], 0.0f, 1.0f));
+        f.m_frustrum_points_trans[0] = glm::vec2(frus1trans.x, frus1trans.y);
+        auto frus2trans = (m_model_inverse * glm::vec4(f.m_frustrum_points[1], 0.0f, 1.0f));
+        f.m_frustrum_points_trans[1] = glm::vec2(frus2trans.x, frus2trans.y);
+    }
+
+    update_frustum_planes();
+    accumulate_view_motion(m_previous_frustrum_2d_vec);
+
+    if (get_ideal_solver()){
+        post_ideal_views();
+        take_ideal_tree();
+    }
+
+    update_tree();
+    update_tree_info(m_tree_current);
+
+    auto time_end = std::chrono::high_resolution_clock::now();
+    m_treeInfo.time_current_tree_update = (size_t)std::chrono::duration_cast<std::chrono::microseconds>(time_end - time_start).count();
+    m_treeInfo.heap_allocations = heap_allocation_count() - allocations_start;
+
+    return m_treeInfo;
+}
+
+const std::vector<QuadtreeEngine::q_node_ptr>&
+QuadtreeEngine::get_leaf_nodes() const
+{
+    return get_leaf_nodes(m_tree_current);
+}
+
+QuadtreeEngine::read_section::read_section(const QuadtreeEngine& engine)
+: m_engine(engine),
+m_slot(engine.m_epochs.enter())
+{
+}
+
+QuadtreeEngine::read_section::~read_section()
+{
+    m_engine.m_epochs.leave(m_slot);
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::read_section::root() const
+{
+    return m_engine.m_tree_current->root_node;
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::read_section::child(const QuadtreeEngine::q_node_ptr n, const unsigned c) const
+{
+    return load_shared(n->child_node[c]);
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::read_section::find_leaf(const glm::uvec2& cell, unsigned& depth) const
+{
+    // the path of find_leaf_below, the leaf flag is no concern of readers
+    const unsigned max_depth = m_engine.m_tree_current->max_depth;
+
+    auto leaf = root();
+    for (depth = 0; depth != max_depth; ++depth){
+        const unsigned shift = max_depth - depth - 1;
+        auto next = child(leaf, ((cell.x >> shift) & 1u) | (((cell.y >> shift) & 1u) << 1));
+        if (next == nullptr)
+            break;
+        leaf = next;
+    }
+    return leaf;
+}
+
+void
+QuadtreeEngine::split_to_depth(const unsigned depth)
+{
+    auto tree = m_tree_current;
+    auto leafs = get_leaf_nodes(tree);
+
+    std::stable_sort(leafs.begin(), leafs.end(), [](const q_node_ptr& lhs, const q_node_ptr& rhs){
+        return lhs->depth < rhs->depth;
+    });
+
+    std::queue<q_node_ptr> node_queue;
+    for (auto& l : leafs){
+        node_queue.push(l);
+    }
+
+    while (!node_queue.empty() && tree->budget_filled + CHILDREN <= tree->budget) {
+        auto n = node_queue.front();
+        node_queue.pop();
+
+        if (n->depth >= depth || !splitable(n)){
+            continue;
+        }
+
+        split_node(n);
+
+        for (unsigned c = 0; c != CHILDREN; ++c){
+            node_queue.push(n->child_node[c]);
+        }
+    }
+
+    update_tree_info(tree);
+}
+
+void
+QuadtreeEngine::update_tree_info(QuadtreeEngine::q_tree_ptr tree){
+
+    auto& leafs = get_leaf_nodes(tree);
+
+    m_treeInfo.min_prio = 99999.0;
+    m_treeInfo.max_prio = -99999.0;
+    m_treeInfo.min_importance = 99999.0;
+    m_treeInfo.max_importance = -99999.0;
+    m_treeInfo.min_error = 99999.0;
+    m_treeInfo.max_error = -99999.0;
+
+    for (auto& l : leafs){
+        m_treeInfo.min_prio = std::min(l->priority, m_treeInfo.min_prio);
+        m_treeInfo.max_prio = std::max(l->priority, m_treeInfo.max_prio);
+        m_treeInfo.min_importance = std::min(l->importance, m_treeInfo.min_importance);
+        m_treeInfo.max_importance = std::max(l->importance, m_treeInfo.max_importance);
+        m_treeInfo.min_error = std::min(l->error, m_treeInfo.min_error);
+        m_treeInfo.max_error = std::max(l->error, m_treeInfo.max_error);
+    }
+
+    m_treeInfo.used_budget = tree->budget_filled;
+    m_treeInfo.max_budget = tree->budget;
+    m_treeInfo.max_depth = tree->max_depth;
+    m_treeInfo.pool_blocks_used = tree->node_pool.blocks_used();
+    m_treeInfo.pool_blocks_capacity = tree->node_pool.capacity();
+    m_treeInfo.collapse_cache_blocks = tree->collapse_cache.size();
+
+    if (following_ideal()){
+        m_treeInfo.used_ideal_budget = m_tree_ideal->budget_filled;
+        m_treeInfo.ideal_distance = get_ideal_distance(tree, m_tree_ideal);
+        m_treeInfo.ideal_age = m_ideal_frame == m_ideal_views_frame ? 0 : m_frame - m_ideal_frame;
+    }
+
+    m_treeInfo.memory_usage = tree->node_pool.slot_count() * q_node_pool::bytes_per_node()
+        + tree->leaf_table.capacity() * (sizeof(index_type) + sizeof(q_node_ptr))
+        + tree->qtree_depth_data.size() * (sizeof(char) + sizeof(unsigned) + sizeof(float));
+}
+
+QuadtreeEngine::q_tree_ptr
+QuadtreeEngine::init_tree() const{
+    auto tree = new q_tree();
+
+    tree->budget = m_tree_current->budget;
+    tree->budget_filled = 0;
+    tree->frame_budget = 9999999;
+    tree->max_depth = m_tree_current->max_depth;
+
+    // nothing is collapsed, the budget is all
+    tree->node_pool.reserve(tree->budget / CHILDREN + 2);
+    tree->leaf_table.reserve(tree->budget + CHILDREN);
+
+    tree->root_node = tree->node_pool.allocate_block();
+    tree->root_node->node_id = 0;
+    tree->root_node->leaf = true;
+    tree->root_node->depth = 0;
+    tree->root_node->priority = 0.0;
+    tree->root_node->error = 0.0;//projection of face to POI/Camera
+
+    tree->root_node->tree = tree;
+    tree->insert_leaf(tree->root_node);
+
+    return tree;
+}
+
+void
+QuadtreeEngine::set_splits_per_frame(const int splits_per_frame)
+{
+	m_tree_current->frame_budget = splits_per_frame;
+	reserve_node_pool(m_tree_current);
+}
+
+void
+QuadtreeEngine::set_frame_time_budget(const float milliseconds)
+{
+    m_frame_time_budget = std::max(milliseconds, 0.0f);
+}
+
+void
+QuadtreeEngine::set_hysteresis(const float band, const unsigned residency_frames)
+{
+    m_hysteresis_band = std::max(band, 0.0f);
+    m_residency_frames = residency_frames;
+}
+
+void
+QuadtreeEngine::set_churn_frames(const unsigned frames)
+{
+    m_churn_frames = frames;
+}
+
+bool
+QuadtreeEngine::deadline_passed() const
+{
+    return std::chrono::high_resolution_clock::now() >= m_frame_deadline;
+}
+
+void
+QuadtreeEngine::set_collapse_cache(const unsigned blocks)
+{
+    auto tree = m_tree_current;
+    if (blocks == tree->collapse_cache.capacity())
+        return;
+
+    // outside of update() only read sections may refer to the evicted blocks
+    while (tree->collapse_cache.size()){
+        evict_cached_children(tree, tree->collapse_cache.oldest());
+    }
+    retire_blocks(tree);
+
+    tree->collapse_cache.reserve(blocks);
+    reserve_node_pool(tree);
+}
+
+void
+QuadtreeEngine::set_thread_pool(thread_pool* pool)
+{
+    // a pool without workers runs the loops inline
+    static thread_pool serial(1);
+
+    m_thread_pool = pool ? pool : &serial;
+    m_quad_batches.resize(m_thread_pool->size());
+    m_border_rings.resize(m_thread_pool->size());
+
+    // a batch never holds more nodes, the workers do not allocate
+    for (auto& b : m_quad_batches){
+        b.nodes.reserve(FRUSTUM_BATCH);
+        b.ids.reserve(FRUSTUM_BATCH);
+        b.positions.reserve(FRUSTUM_BATCH);
+        b.x.reserve(FRUSTUM_BATCH);
+        b.y.reserve(FRUSTUM_BATCH);
+        b.size.reserve(FRUSTUM_BATCH);
+        b.inside.reserve(FRUSTUM_BATCH);
+        b.outside.reserve(FRUSTUM_BATCH);
+    }
+}
+
+void
+QuadtreeEngine::set_ideal_solver(const bool enabled)
+{
+    if (enabled == get_ideal_solver())
+        return;
+
+    if (enabled){
+        m_tree_ideal = init_tree();
+        m_tree_ideal_ready = init_tree();
+        m_tree_ideal_build = init_tree();
+        m_ideal_frame = 0;
+        m_ideal_views_frame = 0;
+        m_ideal_ready_frame = 0;
+        m_ideal_stop = false;
+
+        m_ideal_thread = std::thread(&QuadtreeEngine::run_ideal_solver, this);
+
+        // the views of the last update() until the next one
+        post_ideal_views();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_ideal_mutex);
+        m_ideal_stop = true;
+    }
+    m_ideal_posted.notify_one();
+    m_ideal_thread.join();
+
+    delete_tree(m_tree_ideal);
+    delete_tree(m_tree_ideal_ready);
+    delete_tree(m_tree_ideal_build);
+    m_tree_ideal = nullptr;
+    m_tree_ideal_ready = nullptr;
+    m_tree_ideal_build = nullptr;
+    m_ideal_frame = 0;
+
+    m_treeInfo.used_ideal_budget = 0;
+    m_treeInfo.time_new_tree_update = 0;
+    m_treeInfo.ideal_distance = 0;
+    m_treeInfo.ideal_age = 0;
+}
+
+void
+QuadtreeEngine::get_node_corners(const QuadtreeEngine::q_node_ptr n, glm::vec2 corners[4]) const
+{
+    auto pos = q_layout.node_position(n->node_id);
+    auto node_level = q_layout.level_index(n->node_id);
+    auto total_node_index = q_layout.total_node_count(node_level);
+
+    auto max_pos = q_layout.node_position(total_node_index - 1);
+
+    auto v_pos = glm::vec2((float)pos.x / (max_pos.x + 1.0), (float)pos.y / (max_pos.y + 1.0));
+    auto v_length = 1.0 / (max_pos.x + 1);
+
+    glm::vec2 vpos[4] = {
+        v_pos,
+        glm::vec2(v_pos.x + v_length, v_pos.y),
+        glm::vec2(v_pos.x + v_length, v_pos.y + v_length),
+        glm::vec2(v_pos.x, v_pos.y + v_length)
+    };
+
+    for (unsigned i = 0; i != 4; ++i){
+        glm::vec4 trans = m_model * glm::vec4(vpos[i], 0.0f, 1.0f);
+        corners[i] = glm::vec2(trans.x, trans.y);
+    }
+}
+
+void
+QuadtreeEngine::get_node_quad(const QuadtreeEngine::q_node_ptr n, float& x, float& y, float& size) const
+{
+    auto pos = q_layout.node_position(n->node_id);
+    auto node_level = q_layout.level_index(n->node_id);
+
+    size = 1.0f / (float)(1u << node_level);
+    x = (float)pos.x * size;
+    y = (float)pos.y * size;
+}
+
+void
+QuadtreeEngine::update_frustum_planes()
+{
+    m_frustum_planes.clear();
+
+    for (auto& f : m_frustrum_2d_vec){
+        m_frustum_planes.push_back(make_frustum_planes_2d(f.m_camera_point, f.m_frustrum_points[0], f.m_frustrum_points[1], m_model));
+    }
+
+    ++m_frustum_frame;
+}
+
+void
+QuadtreeEngine::classify_frustrums(QuadtreeEngine::q_node_ptr n) const
+{
+    if (n->frustum_frame == m_frustum_frame)
+        return;
+
+    // a child quad lies in the parent quad, so it is fully inside or
+    // outside of every frustum its parent is fully inside or outside of
+    if (n->parent){
+        classify_frustrums(n->parent);
+        n->frustum_inside = n->parent->frustum_inside;
+        n->frustum_outside = n->parent->frustum_outside;
+    }
+    else{
+        n->frustum_inside = 0;
+        n->frustum_outside = 0;
+    }
+    n->frustum_frame = m_frustum_frame;
+
+    if (((n->frustum_inside | n->frustum_outside) & all_frustums()) == all_frustums())
+        return;
+
+    float x, y, size;
+    get_node_quad(n, x, y, size);
+
+    glm::uint32 inside;
+    glm::uint32 outside;
+    classify_quads_2d(m_frustum_planes.data(), (unsigned)m_frustum_planes.size(), &x, &y, &size, 1, &inside, &outside);
+
+    n->frustum_inside |= inside;
+    n->frustum_outside |= outside;
+}
+
+void
+QuadtreeEngine::classify_frustrums(const QuadtreeEngine::q_node_ptr* nodes, const size_t count,
+                                   QuadtreeEngine::quad_batch& batch, const QuadtreeEngine::q_node_ptr parent)
+{
+    // as the single node version, but the parent is not classified on
+    // demand, other workers may classify the ancestors at the same time
+    glm::uint32 inherited_inside = 0;
+    glm::uint32 inherited_outside = 0;
+    if (parent != nullptr && parent->frustum_frame == m_frustum_frame){
+        inherited_inside = parent->frustum_inside;
+        inherited_outside = parent->frustum_outside;
+    }
+    const bool decided = ((inherited_inside | inherited_outside) & all_frustums()) == all_frustums();
+
+    batch.nodes.clear();
+    batch.ids.clear();
+
+    for (size_t i = 0; i != count; ++i){
+        auto n = nodes[i];
+        if (n->frustum_frame == m_frustum_frame)
+            continue;
+
+        n->frustum_frame = m_frustum_frame;
+        n->frustum_inside = inherited_inside;
+        n->frustum_outside = inherited_outside;
+
+        if (decided)
+            continue;
+
+        batch.nodes.push_back(n);
+        batch.ids.push_back(n->node_id);
+    }
+
+    if (batch.nodes.empty())
+        return;
+
+    // same as get_node_quad, the positions through the batch decoder
+    batch.positions.resize(batch.ids.size());
+    q_layout.node_positions(batch.ids.data(), batch.positions.data(), batch.ids.size());
+
+    batch.x.resize(batch.ids.size());
+    batch.y.resize(batch.ids.size());
+    batch.size.resize(batch.ids.size());
+
+    for (size_t i = 0; i != batch.ids.size(); ++i){
+        const float size = 1.0f / (float)(1u << q_layout.level_index(batch.ids[i]));
+
+        batch.size[i] = size;
+        batch.x[i] = (float)batch.positions[i].x * size;
+        batch.y[i] = (float)batch.positions[i].y * size;
+    }
+
+    batch.inside.resize(batch.nodes.size());
+    batch.outside.resize(batch.nodes.size());
+
+    classify_quads_2d(m_frustum_planes.data(), (unsigned)m_frustum_planes.size(),
+        batch.x.data(), batch.y.data(), batch.size.data(), batch.nodes.size(),
+        batch.inside.data(), batch.outside.data());
+
+    for (size_t i = 0; i != batch.nodes.size(); ++i){
+        batch.nodes[i]->frustum_inside |= batch.inside[i];
+        batch.nodes[i]->frustum_outside |= batch.outside[i];
+    }
+}
+
+bool
+QuadtreeEngine::check_frustrum(QuadtreeEngine::q_node_ptr n) const
+{
+    classify_frustrums(n);
+    return (~n->frustum_outside & all_frustums()) != 0;
+}
+
+
+bool
+QuadtreeEngine::check_frustrum(const unsigned frust_nbr, QuadtreeEngine::q_node_ptr n) const
+{
+    classify_frustrums(n);
+    return ((n->frustum_outside >> frust_nbr) & 1u) == 0;
+}
+
+
+bool
+QuadtreeEngine::check_frustrum(const unsigned frust_nbr, glm::vec2 pos) const
+{
+    return check_frustrum(m_frustrum_2d_vec[frust_nbr], pos);
+}
+
+
+bool
+QuadtreeEngine::check_frustrum(const frustrum_2d& view, glm::vec2 pos)
+{
+    glm::vec2 p1 = view.m_frustrum_points[0];
+    glm::vec2 p2 = view.m_frustrum_points[1];
+
+    glm::vec2 c = view.m_camera_point;
+
+	p1 = p1 + ((p1 - c) * 100.0f);
+	p2 = p2 + ((p2 - c) * 100.0f);
+
+    glm::vec2 n1 = c - p1;
+    n1 = glm::vec2(-n1.y, n1.x);
+
+    glm::vec2 n2 = p2 - c;
+    n2 = glm::vec2(-n2.y, n2.x);
+
+    float s1 = glm::dot(n1, pos - c);
+    float s2 = glm::dot(n2, pos - c);
+
+    //std::cout << "d1: " << s1 << " d2: " << s2 << std::endl;
+
+    if (s1 > 0.0 && s2 > 0.0)
+        return true;
+    else
+        return false;
+
+    //http://upload.wikimedia.org/math/c/a/e/cae82210ba48deb8ff6fb0134a90b36e.png
+
+}
+
+
+void
+QuadtreeEngine::split_node(QuadtreeEngine::q_node_ptr n)
+{
+    begin_split(n);
+    finish_split(n, 0);
+}
+
+void
+QuadtreeEngine::begin_split(QuadtreeEngine::q_node_ptr n)
+{
+    // children collapsed a short while ago come back with their evaluation,
+    // it is only redone once the views moved past their tolerance
+    auto& cache = n->tree->collapse_cache;
+    bool cached = cache.contains(n);
+
+    q_node_ptr block = nullptr;
+    if (cached){
+        block = cache.take(n);
+        ++m_treeInfo.collapse_cache_hits;
+    }
+    else {
+        block = n->tree->node_pool.allocate_block();
+        m_treeInfo.collapse_cache_misses += cache.capacity() ? 1 : 0;
+    }
+
+    n->tree->erase_leaf(n);
+    n->tree->insert_collapsible(n);
+    if (n->parent){
+        n->tree->erase_collapsible(n->parent);
+    }
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+        auto child = block + c;
+        child->parent = n;
+        child->node_id = q_layout.child_node_index(n->node_id, c);
+        child->leaf = true;
+        child->depth = n->depth + 1;
+
+        child->tree = n->tree;
+        child->valid = true;
+
+        // set up before read sections can reach it
+        store_shared(n->child_node[c], child);
+        n->tree->insert_leaf(child);
+
+        if (!cached)
+            invalidate_priority(child);
+    }
+
+    n->tree->budget_filled += CHILDREN;
+    n->leaf = false;
+    n->changed_frame = m_frame;
+}
+
+void
+QuadtreeEngine::finish_split(QuadtreeEngine::q_node_ptr n, const unsigned worker)
+{
+    // writes the children and the links of the leafs touching n only
+    q_node_ptr outdated[CHILDREN];
+    unsigned count = 0;
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+        if (priority_outdated(n->child_node[c]))
+            outdated[count++] = n->child_node[c];
+    }
+
+    // n belongs to this worker, its ancestors do not
+    classify_frustrums(outdated, count, m_quad_batches[worker], n);
+
+    for (unsigned c = 0; c != count; ++c){
+        evaluate_node(outdated[c]);
+    }
+
+    if (m_visualization){
+        for (unsigned c = 0; c != CHILDREN; ++c){
+            rasterize_node(n->child_node[c]);
+        }
+    }
+
+    link_neighbors(n, m_border_rings[worker]);
+}
+
+bool
+QuadtreeEngine::splitable(QuadtreeEngine::q_node_ptr n) const{
+
+    if (n->depth >= n->tree->max_depth){
+        return false;
+    }
+
+    if (n->valid == false)
+        return false;
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+        if (n->child_node[c] != nullptr && n->child_node[c]->valid != false){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+QuadtreeEngine::collabsible(QuadtreeEngine::q_node_ptr n) const{
+
+    if (n == nullptr || n->valid == false){
+        return false;
+    }
+
+    if (n->leaf){
+        return false;
+    }
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+        if (n->child_node[c] != nullptr
+            && n->child_node[c]->valid == true && n->child_node[c]->leaf != true){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void
+QuadtreeEngine::collapse_node(QuadtreeEngine::q_node_ptr n)
+{
+    assert(!n->leaf);
+
+    // the siblings are one pool block, kept in the collapse cache or
+    // handed back once the plan is done
+    auto& cache = n->tree->collapse_cache;
+    if (cache.capacity()){
+        while (cache.full()){
+            evict_cached_children(n->tree, cache.oldest());
+        }
+        cache.push(n, n->child_node[0]);
+    }
+    else {
+        cleanup_container.push_back(n->child_node[0]);
+    }
+
+    if (n->changed_frame != 0 && m_frame - n->changed_frame < m_churn_frames)
+        ++m_treeInfo.churned_splits;
+    n->changed_frame = m_frame;
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+        n->tree->erase_leaf(n->child_node[c]);
+        n->child_node[c]->valid = false;
+        n->child_node[c]->leaf = false;
+        store_shared(n->child_node[c], (q_node_ptr)nullptr);
+    }
+
+    n->tree->erase_collapsible(n);
+    n->tree->insert_leaf(n);
+
+    if (n->parent){
+        bool children_leafs = true;
+        for (auto& c : n->parent->child_node){
+            children_leafs = children_leafs && (c == n || c->leaf);
+        }
+        if (children_leafs){
+            // its priority may be from before its children were split
+            evaluate_node(n->parent);
+            n->tree->insert_collapsible(n->parent);
+        }
+    }
+
+    evaluate_node(n);
+
+    n->tree->budget_filled -= CHILDREN;
+
+    n->leaf = true;
+
+    link_neighbors(n, m_border_rings[0]);
+
+    if (m_visualization)
+        rasterize_node(n);
+}
+
+void
+QuadtreeEngine::evict_cached_children(QuadtreeEngine::q_tree_ptr tree, QuadtreeEngine::q_node_ptr n)
+{
+    auto block = tree->collapse_cache.take(n);
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+        if (tree->collapse_cache.contains(block + c))
+            evict_cached_children(tree, block + c);
+    }
+
+    cleanup_container.push_back(block);
+}
+
+void
+QuadtreeEngine::retire_blocks(QuadtreeEngine::q_tree_ptr tree)
+{
+    const auto epoch = m_epochs.epoch();
+    for (auto& b : cleanup_container){
+        retired_block r = { epoch, b };
+        m_retired_blocks.push_back(r);
+    }
+    cleanup_container.clear();
+
+    if (m_retired_blocks.empty())
+        return;
+
+    // the steps of a pending plan may refer to any of them, see finish_plan
+    if (m_plan_step != m_plan.size())
+        return;
+
+    const auto safe = m_epochs.safe_epoch();
+    size_t freed = 0;
+    while (freed != m_retired_blocks.size() && m_retired_blocks[freed].epoch < safe){
+        tree->node_pool.free_block(m_retired_blocks[freed].block);
+        ++freed;
+    }
+    m_retired_blocks.erase(m_retired_blocks.begin(), m_retired_blocks.begin() + freed);
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::get_cached_neighbor_node(const QuadtreeEngine::q_node_ptr n, const unsigned neighbor_nbr) const
+{
+    // child holding the link of a slot of an inner node, and its slot
+    static const unsigned inner_child[NEIGHBORS + NEIGHBORS / 2] = { 0, 0, 1, 1, 3, 2, 2, 0, 1, 3, 3, 2 };
+    static const unsigned inner_slot[NEIGHBORS + NEIGHBORS / 2] = { 0, 1, 2, 3, 4, 5, 6, 7, 1, 3, 5, 7 };
+
+    q_node_ptr neighbor;
+
+    if (n->leaf && neighbor_nbr < NEIGHBORS){
+        neighbor = n->neighbor_node(neighbor_nbr);
+    }
+    else if (!n->leaf && neighbor_nbr < NEIGHBORS + NEIGHBORS / 2
+        && n->child_node[inner_child[neighbor_nbr]]->leaf){
+        neighbor = n->child_node[inner_child[neighbor_nbr]]->neighbor_node(inner_slot[neighbor_nbr]);
+    }
+    else {
+        return get_neighbor_node(n, n->tree, neighbor_nbr);
+    }
+
+#if defined(QUADTREE_CHECK_NEIGHBOR_LINKS)
+    assert(neighbor == get_neighbor_node(n, n->tree, neighbor_nbr));
+#endif
+
+    return neighbor;
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::get_neighbor_node(const QuadtreeEngine::q_node_ptr n, const QuadtreeEngine::q_tree_ptr tree, const unsigned neighbor_nbr) const
+{
+    glm::uvec2 cell;
+
+    if (!get_neighbor_cell(n, tree, neighbor_nbr, cell))
+    {
+        return nullptr;
+    }
+
+    auto neighbor = find_leaf(tree, cell, n->depth);
+
+    // the cell is outside of n
+    assert(neighbor != n);
+
+    return neighbor;
+}
+
+bool
+QuadtreeEngine::get_neighbor_cell(const QuadtreeEngine::q_node_ptr n, const QuadtreeEngine::q_tree_ptr tree, const unsigned neighbor_nbr, glm::uvec2& cell) const
+{
+    // cell of the finest level next to the node, the leaf covering it is
+    // the neighbor
+    const glm::int64 one_node_to_finest = glm::int64(1) << (tree->max_depth - n->depth);
+    const glm::int64 resolution = glm::int64(1) << tree->max_depth;
+    auto node_pos = q_layout.node_position(n->node_id);
+
+    glm::int64 offset_x = -1;
+    glm::int64 offset_y = -1;
+
+    switch (neighbor_nbr){
+    case 0:
+        offset_x = -1;
+        offset_y = -1;
+        break;
+    case 1:
+        offset_x = 0;
+        offset_y = -1;
+        break;
+    case 2:
+        offset_x = one_node_to_finest;
+        offset_y = -1;
+        break;
+    case 3:
+        offset_x = one_node_to_finest;
+        offset_y = 0;
+        break;
+    case 4:
+        offset_x = one_node_to_finest;
+        offset_y = one_node_to_finest;
+        break;
+    case 5:
+        offset_x = 0;
+        offset_y = one_node_to_finest;
+        break;
+    case 6:
+        offset_x = -1;
+        offset_y = one_node_to_finest;
+        break;
+    case 7:
+        offset_x = -1;
+        offset_y = 0;
+        break;
+    case 8:
+        offset_x = one_node_to_finest / 2;
+        offset_y = -1;
+        break;
+    case 9:
+        offset_x = one_node_to_finest;
+        offset_y = one_node_to_finest / 2;
+        break;
+    case 10:
+        offset_x = one_node_to_finest / 2;
+        offset_y = one_node_to_finest;
+        break;
+    case 11:
+        offset_x = -1;
+        offset_y = one_node_to_finest / 2;
+        break;
+    default:
+        break;
+    }
+
+    auto posx = node_pos.x * one_node_to_finest + offset_x;
+    auto posy = node_pos.y * one_node_to_finest + offset_y;
+
+    if (posx < 0 ||
+        posy < 0 ||
+        posx >= resolution ||
+        posy >= resolution)
+    {
+        return false;
+    }
+
+    cell = glm::uvec2((unsigned)posx, (unsigned)posy);
+    return true;
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::find_leaf(const QuadtreeEngine::q_tree_ptr tree, const glm::uvec2& cell, const unsigned depth) const
+{
+    // exactly one level holds a leaf over the cell. The restriction keeps
+    // it next to the level of the asking node, so the levels are probed
+    // alternating below and above it: depth, depth + 1, depth - 1, ...
+    for (unsigned i = 0; i <= 2 * tree->max_depth; ++i){
+        const int level = (int)depth + ((i & 1) ? (int)(i + 1) / 2 : -(int)(i / 2));
+
+        if (level < 0 || level > (int)tree->max_depth)
+            continue;
+
+        const unsigned shift = tree->max_depth - level;
+        auto leaf = tree->leaf_table.find(q_layout.node_index(glm::uvec2(cell.x >> shift, cell.y >> shift), level));
+
+        if (leaf)
+            return leaf;
+    }
+
+    assert(0);
+    return nullptr;
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::find_leaf_below(const QuadtreeEngine::q_node_ptr n, const glm::uvec2& cell) const
+{
+    auto leaf = n;
+    while (!leaf->leaf){
+        const unsigned shift = n->tree->max_depth - leaf->depth - 1;
+        leaf = leaf->child_node[((cell.x >> shift) & 1u) | (((cell.y >> shift) & 1u) << 1)];
+    }
+    return leaf;
+}
+
+void
+QuadtreeEngine::link_neighbor_slots(const QuadtreeEngine::q_node_ptr n, QuadtreeEngine::q_node_ptr l,
+                                    const QuadtreeEngine::border_ring& ring)
+{
+    // cells inside n resolve below n, the others to a leaf of the ring
+    for (unsigned n_nbr = 0; n_nbr != NEIGHBORS; ++n_nbr){
+        glm::uvec2 cell;
+        q_node_ptr neighbor = nullptr;
+
+        if (get_neighbor_cell(l, l->tree, n_nbr, cell)){
+            if (q_layout.node_index(glm::uvec2(cell.x >> ring.shift, cell.y >> ring.shift), n->depth) == n->node_id){
+                neighbor = find_leaf_below(n, cell);
+            }
+            else {
+                for (size_t b = 0; b != ring.nodes.size(); ++b){
+                    auto& r = ring.cells[b];
+                    if (cell.x - r.x < r.z && cell.y - r.y < r.z){
+                        neighbor = ring.nodes[b];
+                        break;
+                    }
+                }
+            }
+        }
+
+#if defined(QUADTREE_CHECK_NEIGHBOR_LINKS)
+        assert(neighbor == get_neighbor_node(l, l->tree, n_nbr));
+#endif
+        l->neighbor_node(n_nbr) = neighbor;
+    }
+}
+
+void
+QuadtreeEngine::link_neighbors(const QuadtreeEngine::q_node_ptr n, QuadtreeEngine::border_ring& ring)
+{
+    // Every leaf linking into n touches it and so covers a cell of the
+    // ring around n, and every link out of a leaf of n ends in the ring.
+    // The ring is walked leaf by leaf: bottom and top row with the
+    // corners, then the left and right column.
+    auto tree = n->tree;
+    const glm::int64 size = glm::int64(1) << (tree->max_depth - n->depth);
+    const glm::int64 resolution = glm::int64(1) << tree->max_depth;
+    auto node_pos = q_layout.node_position(n->node_id);
+    const glm::int64 x0 = node_pos.x * size;
+    const glm::int64 y0 = node_pos.y * size;
+
+    ring.nodes.clear();
+    ring.cells.clear();
+    ring.shift = tree->max_depth - n->depth;
+
+    for (unsigned side = 0; side != 4; ++side){
+        const bool row = side < 2;
+        const glm::int64 fixed = row ? (side == 0 ? y0 - 1 : y0 + size) : (side == 2 ? x0 - 1 : x0 + size);
+        const glm::int64 first = row ? x0 - 1 : y0;
+        const glm::int64 last = row ? x0 + size : y0 + size - 1;
+
+        if (fixed < 0 || fixed >= resolution)
+            continue;
+
+        for (glm::int64 t = std::max<glm::int64>(first, 0); t <= std::min(last, resolution - 1);){
+            auto cell = row ? glm::uvec2((unsigned)t, (unsigned)fixed) : glm::uvec2((unsigned)fixed, (unsigned)t);
+            auto leaf = find_leaf(tree, cell, n->depth);
+
+            const unsigned leaf_shift = tree->max_depth - leaf->depth;
+            ring.nodes.push_back(leaf);
+            ring.cells.push_back(glm::uvec3((cell.x >> leaf_shift) << leaf_shift, (cell.y >> leaf_shift) << leaf_shift, 1u << leaf_shift));
+
+            t = (t & ~((glm::int64(1) << leaf_shift) - 1)) + (glm::int64(1) << leaf_shift);
+        }
+    }
+
+    // links to n or its former children now resolve below n,
+    // corner leafs may be listed twice which does no harm
+    for (auto& b : ring.nodes){
+        for (unsigned n_nbr = 0; n_nbr != NEIGHBORS; ++n_nbr){
+            auto link = b->neighbor_node(n_nbr);
+            if (link != n && (link == nullptr || link->parent != n))
+                continue;
+
+            glm::uvec2 cell;
+            get_neighbor_cell(b, tree, n_nbr, cell);
+            b->neighbor_node(n_nbr) = find_leaf_below(n, cell);
+        }
+    }
+
+    if (n->leaf){
+        link_neighbor_slots(n, n, ring);
+    }
+    else {
+        for (unsigned c = 0; c != CHILDREN; ++c){
+            link_neighbor_slots(n, n->child_node[c], ring);
+        }
+    }
+}
+
+void
+QuadtreeEngine::check_neighbors_for_level_div(const QuadtreeEngine::q_node_ptr n, const float lvl_diff, QuadtreeEngine::frame_node_vector& p_nodes) const
+{
+    //std::cout << "!" << std::endl;
+
+    assert(n);
+
+    p_nodes.clear();
+
+    for (unsigned n_nbr = 0; n_nbr != NEIGHBORS; ++n_nbr){
+        auto neighbor = get_cached_neighbor_node(n, n_nbr);
+
+        if (neighbor)
+        if (((int)n->depth - (int)neighbor->depth) > lvl_diff){
+            p_nodes.push_back(neighbor);
+        }
+    }
+
+}
+
+
+void
+QuadtreeEngine::check_neighbors_for_split(const QuadtreeEngine::q_node_ptr n, QuadtreeEngine::frame_node_vector& p_nodes) const
+{
+    //std::cout << "!" << std::endl;
+
+    assert(n);
+
+    p_nodes.clear();
+
+    for (unsigned n_nbr = 0; n_nbr != NEIGHBORS; ++n_nbr){
+        auto neighbor = get_cached_neighbor_node(n, n_nbr);
+
+        if (neighbor){
+            if (((int)n->depth - (int)neighbor->depth) >= 1.0){
+                p_nodes.push_back(neighbor);
+            }
+        }
+    }
+
+}
+
+void
+QuadtreeEngine::check_neighbors_for_collapse(const QuadtreeEngine::q_node_ptr n, QuadtreeEngine::frame_node_vector& p_nodes) const
+{
+    //std::cout << "!" << std::endl;
+
+    assert(n);
+    assert(!n->leaf);
+
+    p_nodes.clear();
+
+    for (unsigned n_nbr = 0; n_nbr != (NEIGHBORS + NEIGHBORS / 2); ++n_nbr){
+        auto neighbor = get_cached_neighbor_node(n, n_nbr);
+
+        if (neighbor)
+        if (((int)neighbor->depth) - (int)n->depth == 2){
+            p_nodes.push_back(neighbor);
+			n->checked_mark = m_mark_epoch;
+        }
+    }
+
+}
+
+void
+QuadtreeEngine::check_neighbors_for_restricted(const QuadtreeEngine::q_node_ptr n, QuadtreeEngine::frame_node_vector& p_nodes) const
+{
+    //std::cout << "!" << std::endl;
+
+    assert(n);
+
+    p_nodes.clear();
+
+    for (unsigned n_nbr = 0; n_nbr != NEIGHBORS; ++n_nbr){
+        auto neighbor = get_cached_neighbor_node(n, n_nbr);
+
+        if (neighbor)
+        if (((int)n->depth - (int)neighbor->depth) >= 2.0){
+            p_nodes.push_back(neighbor);
+        }
+    }
+
+}
+
+float
+QuadtreeEngine::get_importance_of_node(q_node_ptr n) const
+{
+    classify_frustrums(n);
+    return get_importance(n->node_id, ~n->frustum_outside & all_frustums(), m_frustrum_2d_vec);
+}
+
+float
+QuadtreeEngine::get_importance(const QuadtreeEngine::index_type node_id, const glm::uint32 visible,
+                               const std::vector<QuadtreeEngine::frustrum_2d>& views) const
+{
+
+    auto pos = glm::vec2(q_layout.node_position(node_id)) + glm::vec2(0.5);
+    auto node_level = q_layout.level_index(node_id);
+
+    size_t max_nodes_finest_level = q_layout.total_node_count_level(node_level);
+    auto resolution = (size_t)glm::sqrt((float)max_nodes_finest_level);
+
+	double l = 1000000.0;
+	
+	unsigned frust_nbr = 0;
+	
+	for (auto& f : views) {
+
+		if ((visible >> frust_nbr) & 1u) {
+			auto camera_pos = (float)resolution * glm::vec2(f.m_camera_point_trans.x, f.m_camera_point_trans.y);
+
+			l = std::min(glm::length(glm::vec2(pos.x, pos.y) - camera_pos) + 1.0, l);
+		}
+
+		++frust_nbr;
+	}
+    auto importance = 1.0f / (l * l);
+
+    //    return 1.0f;
+    return importance;
+
+}
+
+float
+QuadtreeEngine::get_error_of_node(q_node_ptr n) const
+{
+    return get_error(n->depth, n->tree->max_depth, check_frustrum(n));
+}
+
+float
+QuadtreeEngine::get_error(const unsigned node_depth, const unsigned max_depth, const bool visible) const
+{
+
+    float error = 0.0;
+
+	if (!visible)
+	{
+        error = -1.0 * node_depth;
+    }
+    else
+    {
+        auto depth = node_depth + 1;
+				
+		//auto local_error = ((float)m_treeInfo.ref_dim.x / (m_treeInfo.page_dim.x * std::sqrt(depth)) + (float)m_treeInfo.ref_dim.y / (m_treeInfo.page_dim.y * std::sqrt(depth))) * 0.5;
+		auto local_error = 1.0 / ((m_treeInfo.page_dim.x * m_treeInfo.page_dim.y * std::pow((float)CHILDREN, (float)depth)) / ((m_treeInfo.page_dim.x * m_treeInfo.page_dim.y * std::pow((float)CHILDREN, (float)max_depth))));
+
+        error = local_error;
+    }
+    //return 1.0f;
+    return error;
+
+}
+
+float
+QuadtreeEngine::get_priority(const float importance, const float error)
+{
+	auto prio = 0.0f;
+
+	if (error < 0.0) {
+		prio = importance + error;
+	}
+	else {
+		prio = importance * error;
+	}
+
+	return prio;
+}
+
+void
+QuadtreeEngine::evaluate_node(QuadtreeEngine::q_node_ptr n)
+{
+    n->importance = get_importance_of_node(n);
+    n->error = get_error_of_node(n);
+    store_shared(n->priority, get_priority(n->importance, n->error));
+
+    n->valid_view_motion = m_view_motion + get_view_motion_bound(n);
+    n->valid_camera_motion = m_camera_motion + get_camera_motion_bound(n);
+}
+
+void
+QuadtreeEngine::evaluate_nodes(const QuadtreeEngine::q_node_ptr* nodes, const size_t count)
+{
+    // the nodes of a chunk are distinct and evaluate_node only writes to
+    // its node, so the chunks are independent
+    auto evaluate_chunk = [&](size_t begin, size_t end, unsigned worker){
+        auto& batch = m_quad_batches[worker];
+
+        // classify a batch, then evaluate it while its nodes are still cached
+        for (size_t i = begin; i < end; i += FRUSTUM_BATCH){
+            auto batch_size = std::min(end - i, (size_t)FRUSTUM_BATCH);
+
+            // no parent shortcut, a parent may be in the chunk of another
+            // worker
+            classify_frustrums(nodes + i, batch_size, batch);
+
+            for (size_t j = 0; j != batch_size; ++j){
+                evaluate_node(nodes[i + j]);
+            }
+        }
+    };
+
+    m_thread_pool->parallel_for(count, EVALUATE_CHUNK, evaluate_chunk);
+}
+
+size_t
+QuadtreeEngine::evaluate_nodes_until(const QuadtreeEngine::q_node_ptr* nodes, const size_t count,
+                                     const std::chrono::high_resolution_clock::time_point& deadline)
+{
+    if (!time_sliced()) {
+        evaluate_nodes(nodes, count);
+        return count;
+    }
+
+    // at least one chunk per thread, the deadline is checked in between
+    const size_t step = (size_t)EVALUATE_CHUNK * m_thread_pool->size();
+
+    size_t evaluated = 0;
+    while (evaluated != count) {
+        auto batch = std::min(count - evaluated, step);
+        evaluate_nodes(nodes + evaluated, batch);
+        evaluated += batch;
+
+        if (std::chrono::high_resolution_clock::now() >= deadline)
+            break;
+    }
+    return evaluated;
+}
+
+bool
+QuadtreeEngine::priority_outdated(const QuadtreeEngine::q_node_ptr n) const
+{
+    return m_view_motion > n->valid_view_motion
+        || m_camera_motion > n->valid_camera_motion;
+}
+
+void
+QuadtreeEngine::invalidate_priority(QuadtreeEngine::q_node_ptr n)
+{
+    n->valid_view_motion = -1.0f;
+    n->valid_camera_motion = -1.0f;
+}
+
+float
+QuadtreeEngine::get_view_motion_bound(const QuadtreeEngine::q_node_ptr n) const
+{
+    // The frustum test of a node can only flip once a frustum edge line
+    // reaches the quad. Points of the line through c and f at parameter t
+    // move at most (|t| + |1 - t|) times as far as c and f do, so with h the
+    // distance of the quad to the line and r the largest distance of a
+    // corner to c the line stays clear while the motion is below
+    // h / (1 + 2 (r + h) / |f - c|). Quads crossing a line give no slack.
+    glm::vec2 corners[4];
+    get_node_corners(n, corners);
+
+    float bound = std::numeric_limits<float>::max();
+
+    for (auto& f : m_frustrum_2d_vec){
+        glm::vec2 c = f.m_camera_point;
+
+        for (unsigned e = 0; e != 2; ++e){
+            glm::vec2 d = f.m_frustrum_points[e] - c;
+            float d_length = glm::length(d);
+
+            if (d_length <= 0.0f)
+                return 0.0f;
+
+            d /= d_length;
+
+            float side_min = std::numeric_limits<float>::max();
+            float side_max = -std::numeric_limits<float>::max();
+            float r = 0.0f;
+
+            for (auto& p : corners){
+                glm::vec2 v = p - c;
+                float side = d.x * v.y - d.y * v.x;
+                side_min = std::min(side_min, side);
+                side_max = std::max(side_max, side);
+                r = std::max(r, glm::length(v));
+            }
+
+            float h = 0.0f;
+            if (side_min > 0.0f)
+                h = side_min;
+            else if (side_max < 0.0f)
+                h = -side_max;
+            else
+                return 0.0f;
+
+            bound = std::min(bound, h / (1.0f + 2.0f * (r + h) / d_length));
+        }
+    }
+
+    return bound;
+}
+
+float
+QuadtreeEngine::get_camera_motion_bound(const QuadtreeEngine::q_node_ptr n) const
+{
+    // outside of all frustums the priority does not depend on the cameras
+    if (n->error < 0.0 || n->importance <= 0.0)
+        return std::numeric_limits<float>::max();
+
+    // importance is 1/l^2 with l the distance to the nearest camera in
+    // node units, it grows by at most the tolerance while l shrinks by
+    // less than l (1 - 1/sqrt(1 + tolerance))
+    size_t nodes_on_level = q_layout.total_node_count_level(n->depth);
+    float resolution = glm::sqrt((float)nodes_on_level);
+    float l = 1.0f / glm::sqrt(n->importance);
+
+    return l * (1.0f - 1.0f / glm::sqrt(1.0f + m_priority_tolerance)) / resolution;
+}
+
+void
+QuadtreeEngine::accumulate_view_motion(const std::vector<QuadtreeEngine::frustrum_2d>& previous_views)
+{
+    // rebase before the float marks lose precision
+    const float max_motion = 16.0f;
+
+    if (previous_views.size() != m_frustrum_2d_vec.size()){
+        m_priorities_outdated = true;
+        return;
+    }
+
+    float view_motion = 0.0f;
+    float camera_motion = 0.0f;
+
+    for (size_t v = 0; v != m_frustrum_2d_vec.size(); ++v){
+        auto& f = m_frustrum_2d_vec[v];
+        auto& p = previous_views[v];
+
+        view_motion = std::max(view_motion, glm::length(f.m_camera_point - p.m_camera_point));
+        view_motion = std::max(view_motion, glm::length(f.m_frustrum_points[0] - p.m_frustrum_points[0]));
+        view_motion = std::max(view_motion, glm::length(f.m_frustrum_points[1] - p.m_frustrum_points[1]));
+        camera_motion = std::max(camera_motion, glm::length(f.m_camera_point_trans - p.m_camera_point_trans));
+    }
+
+    m_view_motion += view_motion;
+    m_camera_motion += camera_motion;
+
+    if (m_view_motion > max_motion || m_camera_motion > max_motion){
+        m_priorities_outdated = true;
+    }
+}
+
+void
+QuadtreeEngine::reset_view_motion(QuadtreeEngine::q_tree_ptr tree)
+{
+    // inner nodes are included, they are evaluated once they become
+    // parents of leafs again
+    std::stack<q_node_ptr, frame_node_vector> node_stack{frame_node_vector(frame_nodes())};
+    node_stack.push(tree->root_node);
+
+    while (!node_stack.empty()){
+        auto current_node = node_stack.top();
+        node_stack.pop();
+
+        invalidate_priority(current_node);
+
+        if (!current_node->leaf){
+            for (unsigned c = 0; c != CHILDREN; ++c){
+                if (current_node->child_node[c]){
+                    node_stack.push(current_node->child_node[c]);
+                }
+            }
+        }
+
+        // cached children are reused by their priorities too
+        if (auto block = tree->collapse_cache.block(current_node)){
+            for (unsigned c = 0; c != CHILDREN; ++c){
+                node_stack.push(block + c);
+            }
+        }
+    }
+
+    m_view_motion = 0.0f;
+    m_camera_motion = 0.0f;
+    m_priorities_outdated = false;
+}
+
+double
+QuadtreeEngine::get_global_error(const std::vector<QuadtreeEngine::q_node_ptr>& leafs)
+{
+    const double scale = (1.0 / (leafs.size() * m_treeInfo.page_dim.x * m_treeInfo.page_dim.y)) * 10000.0;
+
+    // partial sums of fixed chunks added up in order, the same sum for
+    // any number of threads
+    m_error_sums.assign((leafs.size() + EVALUATE_CHUNK - 1) / EVALUATE_CHUNK, 0.0);
+
+    auto sum_chunk = [&](size_t begin, size_t end, unsigned){
+        auto sum = 0.0;
+        for (size_t i = begin; i != end; ++i){
+            sum += scale * leafs[i]->error * leafs[i]->importance;
+        }
+        m_error_sums[begin / EVALUATE_CHUNK] = sum;
+    };
+
+    m_thread_pool->parallel_for(leafs.size(), EVALUATE_CHUNK, sum_chunk);
+
+    auto global_error = 0.0;
+    for (auto sum : m_error_sums){
+        global_error += sum;
+    }
+    return global_error;
+}
+
+void
+QuadtreeEngine::update_priorities(QuadtreeEngine::q_tree_ptr tree){
+
+    if (m_priorities_outdated) {
+        reset_view_motion(tree);
+    }
+
+    unsigned priority_updates = 0;
+
+    auto& leafs = get_leaf_nodes(tree);
+
+    // only nodes whose priority may have moved past the tolerance,
+    // their frustum tests run as one batch
+    m_evaluate_nodes.clear();
+
+    // time sliced, the leafs after the last evaluated one come first and
+    // the rest keep their priorities until a later frame
+    size_t start = time_sliced() && m_evaluate_cursor < leafs.size() ? m_evaluate_cursor : 0;
+    for (auto l = leafs.begin() + start; l != leafs.end(); ++l){
+        if (priority_outdated(*l)) {
+            m_evaluate_nodes.push_back(*l);
+        }
+    }
+    for (auto l = leafs.begin(); l != leafs.begin() + start; ++l){
+        if (priority_outdated(*l)) {
+            m_evaluate_nodes.push_back(*l);
+        }
+    }
+
+    auto evaluated = evaluate_nodes_until(m_evaluate_nodes.data(), m_evaluate_nodes.size(), m_evaluation_deadline);
+    if (evaluated != m_evaluate_nodes.size())
+        m_evaluate_cursor = m_evaluate_nodes[evaluated - 1]->leaf_index + 1;
+
+    priority_updates += (unsigned)evaluated;
+    m_treeInfo.deferred_evaluations = (unsigned)(m_evaluate_nodes.size() - evaluated);
+
+    auto global_error = get_global_error(leafs);
+
+    m_treeInfo.global_error_difference = global_error - m_treeInfo.global_error;
+    m_treeInfo.global_error = global_error;
+
+
+    // parents in the order of their leafs above
+    m_evaluate_nodes.clear();
+    for (size_t i = 0; i != leafs.size(); ++i) {
+        auto l = leafs[i < leafs.size() - start ? start + i : i - (leafs.size() - start)];
+        auto p = l->parent;
+        if (!p || !priority_outdated(p))
+            continue;
+
+        // listed once, by its first leaf child
+        unsigned c = 0;
+        while (!p->child_node[c]->leaf)
+            ++c;
+        if (p->child_node[c] == l) {
+            m_evaluate_nodes.push_back(p);
+        }
+    }
+
+    evaluated = evaluate_nodes_until(m_evaluate_nodes.data(), m_evaluate_nodes.size(), m_evaluation_deadline);
+    priority_updates += (unsigned)evaluated;
+    m_treeInfo.deferred_evaluations += (unsigned)(m_evaluate_nodes.size() - evaluated);
+
+    // re-evaluated collapse candidates move in place
+    for (size_t i = 0; i != evaluated; ++i) {
+        auto p = m_evaluate_nodes[i];
+        if (tree->collapsible_heap.contains(p))
+            tree->collapsible_heap.update(p);
+    }
+
+    m_treeInfo.priority_updates = priority_updates;
+}
+
+void
+QuadtreeEngine::advance_mark_epoch(QuadtreeEngine::q_tree_ptr tree) {
+
+    // clears the marks of all nodes
+    if (++m_mark_epoch != 0)
+        return;
+
+    // wrapped around, stamps of old epochs could match again
+    m_mark_epoch = 1;
+
+    std::stack<q_node_ptr, frame_node_vector> node_stack{frame_node_vector(frame_nodes())};
+
+    node_stack.push(tree->root_node);
+
+    q_node_ptr current_node;
+
+    while (!node_stack.empty()) {
+        current_node = node_stack.top();
+        node_stack.pop();
+
+        current_node->checked_mark = 0;
+        current_node->plan_mark = 0;
+
+        if (!current_node->leaf) {
+            for (unsigned c = 0; c != CHILDREN; ++c) {
+                if (current_node->child_node[c]) {
+                    node_stack.push(current_node->child_node[c]);
+                }
+            }
+        }
+
+        if (auto block = tree->collapse_cache.block(current_node)) {
+            for (unsigned c = 0; c != CHILDREN; ++c) {
+                node_stack.push(block + c);
+            }
+        }
+    }
+}
+
+
+void
+QuadtreeEngine::update_importance_map(QuadtreeEngine::q_tree_ptr tree) {
+
+    if (!m_visualization)
+        return;
+
+    auto& leafs = get_leaf_nodes(tree);
+
+    for (auto& n : leafs) {
+        rasterize_node(n);
+    }
+       
+}
+
+void
+QuadtreeEngine::resize_rasters(QuadtreeEngine::q_tree_ptr tree)
+{
+    size_t max_nodes_finest_level = q_layout.total_node_count_level(tree->max_depth);
+
+    tree->qtree_depth_data.assign(max_nodes_finest_level, 0);
+    tree->qtree_id_data.assign(max_nodes_finest_level, 0);
+    tree->qtree_importance_data.assign(max_nodes_finest_level, 0);
+
+    for (auto& n : tree->leaf_nodes) {
+        rasterize_node(n);
+    }
+}
+
+void
+QuadtreeEngine::rasterize_node(const QuadtreeEngine::q_node_ptr n)
+{
+    ///////setting node index image
+    size_t max_nodes_finest_level = q_layout.total_node_count_level(n->tree->max_depth);
+    auto nodes_on_lvl = q_layout.total_node_count_level(n->depth);
+    auto one_node_to_finest = glm::sqrt((float)max_nodes_finest_level / nodes_on_lvl);
+    auto node_pos = q_layout.node_position(n->node_id);
+    auto resolution = (size_t)glm::sqrt((float)max_nodes_finest_level);
+
+    for (unsigned y = 0; y != one_node_to_finest; ++y) {
+        for (unsigned x = 0; x != one_node_to_finest; ++x) {
+            size_t index = (node_pos.x * one_node_to_finest + x) + (resolution - 1 - ((node_pos.y) * one_node_to_finest + y)) * resolution;
+            n->tree->qtree_depth_data[index] = n->depth;
+            n->tree->qtree_id_data[index] = (unsigned)n->node_id;
+            //n->tree->qtree_importance_data[index] = n->importance;
+            //n->tree->qtree_importance_data[index] = n->error;
+            n->tree->qtree_importance_data[index] = n->priority;
+        }
+    }
+}
+
+void
+QuadtreeEngine::set_visualization(const bool enabled)
+{
+    if (enabled == m_visualization)
+        return;
+
+    m_visualization = enabled;
+
+    if (enabled) {
+        resize_rasters(m_tree_current);
+    }
+    else {
+        std::vector<char>().swap(m_tree_current->qtree_depth_data);
+        std::vector<unsigned>().swap(m_tree_current->qtree_id_data);
+        std::vector<float>().swap(m_tree_current->qtree_importance_data);
+    }
+}
+
+
+void
+QuadtreeEngine::set_max_neigbor_priorities(QuadtreeEngine::q_tree_ptr tree){
+
+
+    frame_node_vector leaf_nodes(frame_nodes());
+
+    for (auto d = tree->max_depth; d != 0; --d){
+        get_leaf_nodes_with_depth_outside(tree, d, leaf_nodes);
+
+        for (auto& n : leaf_nodes){
+            //set_priority_to_neighbor_max(n);
+            for (unsigned n_nbr = 0; n_nbr != (NEIGHBORS + NEIGHBORS / 2); ++n_nbr){
+                auto neighbor = get_cached_neighbor_node(n, n_nbr);
+
+                if (neighbor)
+                {
+                    //n->priority = glm::max(n->priority, neighbor->priority);
+                }
+            }
+        }
+    }
+
+}
+
+QuadtreeEngine::frame_leaf_map
+QuadtreeEngine::get_all_current_leafs(QuadtreeEngine::q_tree_ptr tree)
+{
+    frame_leaf_map leaf_node_map{frame_leaf_map::allocator_type(m_frame_arena)};
+
+    for (auto& l : tree->leaf_nodes){
+        leaf_node_map.insert(std::pair<index_type, q_node_ptr>(l->node_id, l));
+    }
+
+    return leaf_node_map;
+}
+
+void
+QuadtreeEngine::get_splitable_nodes(QuadtreeEngine::q_tree_ptr t, QuadtreeEngine::frame_node_vector& split_able_nodes) const
+{
+    split_able_nodes.clear();
+    split_able_nodes.reserve(t->leaf_nodes.size());
+
+    for (auto& l : t->leaf_nodes){
+        if (splitable(l))
+            split_able_nodes.push_back(l);
+    }
+}
+
+
+const std::vector<QuadtreeEngine::q_node_ptr>&
+QuadtreeEngine::get_leaf_nodes(QuadtreeEngine::q_tree_ptr t) const
+{
+    return t->leaf_nodes;
+}
+
+void
+QuadtreeEngine::get_leaf_nodes_with_depth_outside(QuadtreeEngine::q_tree_ptr t, const unsigned depth, QuadtreeEngine::frame_node_vector& leaf_nodes) const
+{
+    leaf_nodes.clear();
+
+    for (auto& l : t->leaf_nodes){
+        if (l->depth == depth && check_frustrum(l))
+            leaf_nodes.push_back(l);
+    }
+}
+
+
+bool
+QuadtreeEngine::is_node_inside_tree(q_node_ptr node, q_tree_ptr tree){
+
+    const unsigned shift = tree->max_depth - node->depth;
+    auto node_pos = q_layout.node_position(node->node_id);
+    auto cell = glm::uvec2(node_pos.x << shift, node_pos.y << shift);
+
+    assert(node == find_leaf(node->tree, cell, node->depth));
+
+    if (find_leaf(tree, cell, node->depth)->depth >= node->depth + 1){
+        return true;
+    }
+
+    return false;
+}
+
+bool
+QuadtreeEngine::is_child_node_inside_tree(q_node_ptr n, q_tree_ptr tree){
+
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+
+        const unsigned shift = tree->max_depth - n->child_node[c]->depth;
+        auto node_pos = q_layout.node_position(n->child_node[c]->node_id);
+        auto cell = glm::uvec2(node_pos.x << shift, node_pos.y << shift);
+
+        auto ideal_node = find_leaf(tree, cell, n->child_node[c]->depth);
+        
+        assert(n->child_node[c] == find_leaf(n->tree, cell, n->child_node[c]->depth));
+
+        if (ideal_node->depth >= n->child_node[c]->depth){
+            return true;
+        }
+    }    
+    return false;
+}
+
+
+void
+QuadtreeEngine::post_ideal_views()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_ideal_mutex);
+
+        // the ideal tree of the same views is solved or under way
+        if (m_ideal_views_frame != 0 && same_views(m_ideal_views, m_frustrum_2d_vec))
+            return;
+
+        // both keep their storage
+        m_ideal_views = m_frustrum_2d_vec;
+        m_ideal_planes = m_frustum_planes;
+        m_ideal_views_frame = m_frame;
+    }
+    m_ideal_posted.notify_one();
+}
+
+void
+QuadtreeEngine::take_ideal_tree()
+{
+    std::lock_guard<std::mutex> lock(m_ideal_mutex);
+
+    if (m_ideal_ready_frame == 0)
+        return;
+
+    // the worker solves into the one given back next
+    std::swap(m_tree_ideal, m_tree_ideal_ready);
+    m_ideal_frame = m_ideal_ready_frame;
+    m_ideal_ready_frame = 0;
+
+    m_treeInfo.time_new_tree_update = m_ideal_ready_time;
+}
+
+void
+QuadtreeEngine::run_ideal_solver()
+{
+    ideal_scratch s;
+    s.frame = 0;
+
+    for (;;){
+        {
+            std::unique_lock<std::mutex> lock(m_ideal_mutex);
+            m_ideal_posted.wait(lock, [&]{ return m_ideal_stop || m_ideal_views_frame != s.frame; });
+            if (m_ideal_stop)
+                return;
+
+            s.views = m_ideal_views;
+            s.planes = m_ideal_planes;
+            s.frame = m_ideal_views_frame;
+        }
+
+        auto time_start = std::chrono::high_resolution_clock::now();
+        solve_ideal_tree(m_tree_ideal_build, s);
+        auto time_end = std::chrono::high_resolution_clock::now();
+
+        // an ideal tree not taken yet is replaced
+        std::lock_guard<std::mutex> lock(m_ideal_mutex);
+        std::swap(m_tree_ideal_ready, m_tree_ideal_build);
+        m_ideal_ready_frame = s.frame;
+        m_ideal_ready_time = (size_t)std::chrono::duration_cast<std::chrono::microseconds>(time_end - time_start).count();
+    }
+}
+
+void
+QuadtreeEngine::solve_ideal_tree(QuadtreeEngine::q_tree_ptr tree, QuadtreeEngine::ideal_scratch& s) const
+{
+    s.heap.clear();
+
+    // back to the root alone. Freeing a block clears the leaf flags, the
+    // blocks are all found first.
+    s.blocks.clear();
+    s.closure.assign(1, tree->root_node);
+    for (size_t i = 0; i != s.closure.size(); ++i){
+        auto n = s.closure[i];
+        if (n->leaf)
+            continue;
+
+        s.blocks.push_back(n->child_node[0]);
+        for (unsigned c = 0; c != CHILDREN; ++c){
+            s.closure.push_back(n->child_node[c]);
+        }
+    }
+    for (auto& b : s.blocks){
+        tree->node_pool.free_block(b);
+    }
+
+    tree->leaf_nodes.clear();
+    tree->leaf_table.clear();
+    tree->budget_filled = 0;
+
+    auto root = tree->root_node;
+    root->reset();
+    root->leaf = true;
+    root->tree = tree;
+    tree->insert_leaf(root);
+
+    evaluate_ideal_node(root, s);
+    s.heap.push(root);
+
+    // the leaf of the highest priority splits next, with the coarser
+    // leafs it needs split first, until the budget is used up
+    while (!s.heap.empty() && tree->budget_filled + CHILDREN <= tree->budget){
+        auto n = s.heap.pop();
+        if (n->depth >= tree->max_depth)
+            continue;
+
+        s.closure.assign(1, n);
+        for (size_t i = 0; i != s.closure.size(); ++i){
+            auto c = s.closure[i];
+
+            for (unsigned n_nbr = 0; n_nbr != NEIGHBORS; ++n_nbr){
+                glm::uvec2 cell;
+                if (!get_neighbor_cell(c, tree, n_nbr, cell))
+                    continue;
+
+                auto neighbor = find_leaf(tree, cell, c->depth);
+                if (neighbor->depth < c->depth && std::find(s.closure.begin(), s.closure.end(), neighbor) == s.closure.end())
+                    s.closure.push_back(neighbor);
+            }
+        }
+
+        // passed over if it does not fit any more, smaller ones still may
+        if (tree->budget_filled + s.closure.size() * CHILDREN > tree->budget)
+            continue;
+
+        // coarsest first; ids grow with the level
+        std::sort(s.closure.begin(), s.closure.end(), [](const q_node_ptr& lhs, const q_node_ptr& rhs){
+            return lhs->node_id < rhs->node_id;
+        });
+
+        for (auto& c : s.closure){
+            split_ideal_node(c, s);
+        }
+    }
+}
+
+void
+QuadtreeEngine::split_ideal_node(QuadtreeEngine::q_node_ptr n, QuadtreeEngine::ideal_scratch& s) const
+{
+    auto tree = n->tree;
+
+    if (s.heap.contains(n))
+        s.heap.erase(n);
+
+    auto block = tree->node_pool.allocate_block();
+    tree->erase_leaf(n);
+
+    for (unsigned c = 0; c != CHILDREN; ++c){
+        n->child_node[c] = block + c;
+        n->child_node[c]->parent = n;
+        n->child_node[c]->node_id = q_layout.child_node_index(n->node_id, c);
+        n->child_node[c]->leaf = true;
+        n->child_node[c]->depth = n->depth + 1;
+        n->child_node[c]->tree = tree;
+        tree->insert_leaf(n->child_node[c]);
+
+        evaluate_ideal_node(n->child_node[c], s);
+        s.heap.push(n->child_node[c]);
+    }
+
+    tree->budget_filled += CHILDREN;
+    n->leaf = false;
+}
+
+void
+QuadtreeEngine::evaluate_ideal_node(QuadtreeEngine::q_node_ptr n, const QuadtreeEngine::ideal_scratch& s) const
+{
+    // as classify_frustrums and evaluate_node, against the views of s
+    const glm::uint32 all = all_frustums(s.planes.size());
+
+    n->frustum_inside = n->parent ? n->parent->frustum_inside : 0;
+    n->frustum_outside = n->parent ? n->parent->frustum_outside : 0;
+
+    if (((n->frustum_inside | n->frustum_outside) & all) != all){
+        float x, y, size;
+        get_node_quad(n, x, y, size);
+
+        glm::uint32 inside;
+        glm::uint32 outside;
+        classify_quads_2d(s.planes.data(), (unsigned)s.planes.size(), &x, &y, &size, 1, &inside, &outside);
+
+        n->frustum_inside |= inside;
+        n->frustum_outside |= outside;
+    }
+
+    const glm::uint32 visible = ~n->frustum_outside & all;
+
+    n->importance = get_importance(n->node_id, visible, s.views);
+    n->error = get_error(n->depth, n->tree->max_depth, visible != 0);
+    n->priority = get_priority(n->importance, n->error);
+}
+
+unsigned
+QuadtreeEngine::get_ideal_distance(const QuadtreeEngine::q_tree_ptr current, const QuadtreeEngine::q_tree_ptr ideal)
+{
+    // leafs of both trees do not count, they are found as in plan_ideal_steps
+    auto& node_pairs = m_ideal_node_pairs;
+    node_pairs.clear();
+    node_pairs.push_back(current->root_node);
+    node_pairs.push_back(ideal->root_node);
+
+    size_t shared = 0;
+    while (!node_pairs.empty()) {
+        auto i = node_pairs.back();
+        node_pairs.pop_back();
+        auto n = node_pairs.back();
+        node_pairs.pop_back();
+
+        if (n->leaf || i->leaf) {
+            shared += n->leaf && i->leaf ? 1 : 0;
+            continue;
+        }
+
+        for (unsigned c = 0; c != CHILDREN; ++c) {
+            node_pairs.push_back(n->child_node[c]);
+            node_pairs.push_back(i->child_node[c]);
+        }
+    }
+
+    return (unsigned)(current->leaf_nodes.size() + ideal->leaf_nodes.size() - 2 * shared);
+}
+
+bool
+QuadtreeEngine::planned_split(const QuadtreeEngine::q_node_ptr n) const
+{
+    return n->leaf && is_marked(n->plan_mark);
+}
+
+bool
+QuadtreeEngine::planned_collapse(const QuadtreeEngine::q_node_ptr n) const
+{
+    return n && !n->leaf && is_marked(n->plan_mark);
+}
+
+bool
+QuadtreeEngine::resident(const QuadtreeEngine::q_node_ptr n) const
+{
+    return n->changed_frame == 0 || m_frame - n->changed_frame >= m_residency_frames;
+}
+
+bool
+QuadtreeEngine::get_split_closure(const QuadtreeEngine::q_node_ptr n, const unsigned max_splits,
+                                  QuadtreeEngine::frame_node_vector& closure, QuadtreeEngine::frame_node_vector& dependend_nodes) const
+{
+    // n and the coarser neighbors that have to split before it, transitively,
+    // without the splits planned already
+    closure.clear();
+    closure.push_back(n);
+
+    for (size_t i = 0; i != closure.size(); ++i) {
+        auto c = closure[i];
+
+        if (closure.size() > max_splits || !splitable(c) || !resident(c) || planned_collapse(c->parent))
+            return false;
+
+        // the children of c must not end up next to a collapsed node two
+        // levels above them
+        for (unsigned n_nbr = 0; n_nbr != NEIGHBORS; ++n_nbr) {
+            auto neighbor = get_cached_neighbor_node(c, n_nbr);
+            if (neighbor && planned_collapse(neighbor->parent) && c->depth > neighbor->parent->depth)
+                return false;
+        }
+
+        check_neighbors_for_split(c, dependend_nodes);
+        for (auto& d : dependend_nodes) {
+            if (!planned_split(d) && std::find(closure.begin(), closure.end(), d) == closure.end())
+                closure.push_back(d);
+        }
+    }
+
+    // coarsest first, the order the splits are applied in; ids grow with the level
+    std::sort(closure.begin(), closure.end(), [](const q_node_ptr& lhs, const q_node_ptr& rhs){
+        return lhs->node_id < rhs->node_id;
+    });
+    return true;
+}
+
+float
+QuadtreeEngine::get_split_gain(const QuadtreeEngine::q_node_ptr n, const QuadtreeEngine::frame_node_vector& closure) const
+{
+    // a forced split is worth at least the split that forces it
+    float gain = 0.0f;
+    for (auto& c : closure) {
+        gain += std::max(c->priority, n->priority);
+    }
+    return gain / (float)closure.size();
+}
+
+QuadtreeEngine::q_node_ptr
+QuadtreeEngine::plan_collapse(QuadtreeEngine::q_tree_ptr current, const float gain,
+                              QuadtreeEngine::frame_node_vector& held_back_nodes, QuadtreeEngine::frame_node_vector& dependend_nodes)
+{
+    auto& colap_able_heap = current->collapsible_heap;
+
+    while (!colap_able_heap.empty()) {
+        auto n = colap_able_heap.top();
+
+        // the cheapest candidate, none of the others pays off either. The
+        // band is relative to the magnitude, nodes outside all frustums
+        // have negative priorities.
+        if (!((n->priority + std::abs(n->priority) * m_hysteresis_band) < gain))
+            return nullptr;
+
+        colap_able_heap.pop();
+
+        // split too recently, back in at the end of the frame
+        if (!resident(n)) {
+            held_back_nodes.push_back(n);
+            continue;
+        }
+
+        // neither its children nor finer leafs around it may be planned to split
+        bool conflict = false;
+        for (unsigned c = 0; c != CHILDREN; ++c) {
+            conflict = conflict || planned_split(n->child_node[c]);
+        }
+        for (unsigned n_nbr = 0; n_nbr != (NEIGHBORS + NEIGHBORS / 2); ++n_nbr) {
+            auto neighbor = get_cached_neighbor_node(n, n_nbr);
+            conflict = conflict || (neighbor && planned_split(neighbor) && neighbor->depth > n->depth);
+        }
+
+        if (!conflict && collabsible(n)) {
+            check_neighbors_for_collapse(n, dependend_nodes);
+            if (dependend_nodes.empty())
+                return n;
+        }
+
+        held_back_nodes.push_back(n);
+    }
+    return nullptr;
+}
+
+unsigned
+QuadtreeEngine::plan_current_tree(QuadtreeEngine::q_tree_ptr current, std::vector<QuadtreeEngine::plan_step>& plan,
+                                  QuadtreeEngine::frame_node_vector& held_back_nodes)
+{
+    const unsigned frame_splits = current->frame_budget;
+    if (frame_splits == 0)
+        return 0;
+
+    // the top candidates, unordered
+    frame_node_vector split_able_nodes(frame_nodes());
+    get_splitable_nodes(current, split_able_nodes);
+
+    auto count = std::min(split_able_nodes.size(), (size_t)frame_splits * PLAN_CANDIDATES);
+    std::nth_element(split_able_nodes.begin(), split_able_nodes.begin() + count, split_able_nodes.end(), greater_prio_ptr());
+
+    frame_node_vector closure(frame_nodes());
+    frame_node_vector dependend_nodes(frame_nodes());
+    frame_node_vector collapse_nodes(frame_nodes());
+    dependend_nodes.reserve(NEIGHBORS + NEIGHBORS / 2);
+
+    // best gain per split first. The gain of a candidate is recomputed once
+    // other closures were planned, which may have taken some of its nodes.
+    unsigned version = 0;
+    std::priority_queue<plan_candidate, frame_candidate_vector> candidates{std::less<plan_candidate>(),
+        frame_candidate_vector(frame_allocator<plan_candidate>(m_frame_arena))};
+
+    for (size_t i = 0; i != count; ++i) {
+        auto n = split_able_nodes[i];
+        if (get_split_closure(n, frame_splits, closure, dependend_nodes)) {
+            plan_candidate candidate = { get_split_gain(n, closure), version, n };
+            candidates.push(candidate);
+        }
+    }
+
+    // the frame budget counts the requested splits, each brings its closure
+    unsigned planned_requests = 0;
+    unsigned planned_splits = 0;
+    long free_nodes = (long)current->budget - (long)current->budget_filled;
+
+    while (!candidates.empty() && planned_requests != frame_splits) {
+        auto candidate = candidates.top();
+        candidates.pop();
+
+        if (planned_split(candidate.node))
+            continue;
+
+        if (!get_split_closure(candidate.node, frame_splits, closure, dependend_nodes))
+            continue;
+
+        auto gain = get_split_gain(candidate.node, closure);
+        if (candidate.version != version && !candidates.empty() && gain < candidates.top().gain) {
+            candidate.gain = gain;
+            candidate.version = version;
+            candidates.push(candidate);
+            continue;
+        }
+
+        for (auto& n : closure) {
+            n->plan_mark = m_mark_epoch;
+        }
+
+        // the nodes the budget lacks come from collapses cheaper than the gain
+        long needed = (long)closure.size() * CHILDREN - free_nodes;
+
+        collapse_nodes.clear();
+        while (needed > 0) {
+            auto n = plan_collapse(current, gain, held_back_nodes, dependend_nodes);
+            if (!n)
+                break;
+
+            n->plan_mark = m_mark_epoch;
+            collapse_nodes.push_back(n);
+            needed -= CHILDREN;
+        }
+
+        if (needed > 0) {
+            for (auto& n : closure) {
+                n->plan_mark = 0;
+            }
+            for (auto& n : collapse_nodes) {
+                n->plan_mark = 0;
+                current->insert_collapsible(n);
+            }
+            continue;
+        }
+
+        for (auto& n : collapse_nodes) {
+            plan_step step = { n, true };
+            plan.push_back(step);
+        }
+        for (auto& n : closure) {
+            plan_step step = { n, false };
+            plan.push_back(step);
+        }
+
+        free_nodes += (long)collapse_nodes.size() * CHILDREN - (long)closure.size() * CHILDREN;
+        planned_splits += (unsigned)closure.size();
+        ++planned_requests;
+
+        auto forced_splits = (unsigned)closure.size() - 1;
+        m_treeInfo.forced_splits += forced_splits;
+        m_treeInfo.max_forced_splits = std::max(m_treeInfo.max_forced_splits, forced_splits);
+        ++version;
+    }
+
+    return planned_splits;
+}
+
+unsigned
+QuadtreeEngine::plan_ideal_steps(QuadtreeEngine::q_tree_ptr current, std::vector<QuadtreeEngine::plan_step>& plan)
+{
+    const unsigned frame_steps = current->frame_budget;
+    if (frame_steps == 0)
+        return 0;
+
+    auto ideal = m_tree_ideal;
+
+    frame_node_vector split_nodes(frame_nodes());
+    frame_node_vector closure(frame_nodes());
+    frame_node_vector dependend_nodes(frame_nodes());
+    dependend_nodes.reserve(NEIGHBORS + NEIGHBORS / 2);
+
+    frame_node_vector node_pairs(frame_nodes());
+    frame_node_vector collapse_nodes(frame_nodes());
+
+    // both trees top down side by side, they differ below a leaf of either:
+    // a leaf of the current tree only is split, and nodes over leafs of
+    // the current tree only whose children are all leafs are collapsed
+    node_pairs.push_back(current->root_node);
+    node_pairs.push_back(ideal->root_node);
+
+    while (!node_pairs.empty()) {
+        auto i = node_pairs.back();
+        node_pairs.pop_back();
+        auto n = node_pairs.back();
+        node_pairs.pop_back();
+
+        if (n->leaf) {
+            if (!i->leaf)
+                split_nodes.push_back(n);
+            continue;
+        }
+
+        if (i->leaf) {
+            collapse_nodes.push_back(n);
+            continue;
+        }
+
+        for (unsigned c = 0; c != CHILDREN; ++c) {
+            node_pairs.push_back(n->child_node[c]);
+            node_pairs.push_back(i->child_node[c]);
+        }
+    }
+
+    long free_nodes = (long)current->budget - (long)current->budget_filled;
+
+    unsigned collapses = 0;
+    for (size_t k = 0; k != collapse_nodes.size() && collapses != frame_steps; ++k) {
+        auto n = collapse_nodes[k];
+
+        // the finer ones first, over several frames
+        if (!current->collapsible_heap.contains(n)) {
+            for (unsigned c = 0; c != CHILDREN; ++c) {
+                if (!n->child_node[c]->leaf)
+                    collapse_nodes.push_back(n->child_node[c]);
+            }
+            continue;
+        }
+
+        if (!resident(n) || !collabsible(n))
+            continue;
+
+        check_neighbors_for_collapse(n, dependend_nodes);
+        if (!dependend_nodes.empty())
+            continue;
+
+        n->plan_mark = m_mark_epoch;
+        plan_step step = { n, true };
+        plan.push_back(step);
+
+        free_nodes += CHILDREN;
+        ++collapses;
+    }
+
+    // coarsest first, the finer ones may need them; ids grow with the level
+    auto count = std::min(split_nodes.size(), (size_t)frame_steps * PLAN_CANDIDATES);
+    std::partial_sort(split_nodes.begin(), split_nodes.begin() + count, split_nodes.end(), [](const q_node_ptr& lhs, const q_node_ptr& rhs){
+        return lhs->node_id < rhs->node_id;
+    });
+
+    unsigned planned_requests = 0;
+    unsigned planned_splits = 0;
+
+    for (size_t i = 0; i != count && planned_requests != frame_steps; ++i) {
+        auto n = split_nodes[i];
+
+        if (planned_split(n) || !get_split_closure(n, frame_steps, closure, dependend_nodes))
+            continue;
+
+        if ((long)closure.size() * CHILDREN > free_nodes)
+            continue;
+
+        for (auto& c : closure) {
+            c->plan_mark = m_mark_epoch;
+            plan_step step = { c, false };
+            plan.push_back(step);
+        }
+
+        free_nodes -= (long)closure.size() * CHILDREN;
+        planned_splits += (unsigned)closure.size();
+        ++planned_requests;
+    }
+
+    return planned_splits;
+}
+
+bool
+QuadtreeEngine::apply_plan_step(QuadtreeEngine::q_tree_ptr current, const QuadtreeEngine::plan_step& step,
+                                QuadtreeEngine::frame_node_vector& held_back_nodes, QuadtreeEngine::frame_node_vector& dependend_nodes)
+{
+    // the tree may differ from the plan where planned steps interact, every
+    // step is checked again before it is applied
+    auto n = step.node;
+
+    if (step.collapse) {
+        if (collabsible(n)) {
+            check_neighbors_for_collapse(n, dependend_nodes);
+            if (dependend_nodes.empty()) {
+                collapse_node(n);
+                return false;
+            }
+        }
+        held_back_nodes.push_back(n);
+    }
+    else if (n->leaf && splitable(n) && current->budget_filled + CHILDREN <= current->budget) {
+        check_neighbors_for_split(n, dependend_nodes);
+        if (dependend_nodes.empty()) {
+            split_node(n);
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned
+QuadtreeEngine::color_plan_steps(const QuadtreeEngine::q_tree_ptr current, const QuadtreeEngine::plan_step* steps, const size_t count,
+                                 std::vector<unsigned, frame_allocator<unsigned> >& sets)
+{
+    // Two steps conflict if a leaf may touch both quads. A split only
+    // passes with no coarser leaf around it, a collapse leaves leafs up to
+    // twice its size around it, so no leaf touching both is larger than
+    // the smaller of these reaches.
+    std::vector<glm::uvec4, frame_allocator<glm::uvec4> > quads{frame_allocator<glm::uvec4>(m_frame_arena)};
+    std::vector<unsigned, frame_allocator<unsigned> > order{frame_allocator<unsigned>(m_frame_arena)};
+    quads.reserve(count);
+    order.reserve(count);
+
+    for (size_t i = 0; i != count; ++i){
+        auto n = steps[i].node;
+        const unsigned shift = n->tree->max_depth - n->depth;
+        const unsigned size = 1u << shift;
+        auto pos = q_layout.node_position(n->node_id);
+
+        // corner, size and reach on the finest level
+        quads.push_back(glm::uvec4(pos.x << shift, pos.y << shift, size, steps[i].collapse ? 2 * size : size));
+        order.push_back((unsigned)i);
+    }
+
+    // conflicting pairs, later step in the high half. Swept along x, no
+    // quad further right than the size and reach of a quad conflicts with it.
+    std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b){ return quads[a].x < quads[b].x; });
+
+    std::vector<glm::uint64, frame_allocator<glm::uint64> > pairs{frame_allocator<glm::uint64>(m_frame_arena)};
+    std::vector<unsigned, frame_allocator<unsigned> > first_pair(count + 1, 0, frame_allocator<unsigned>(m_frame_arena));
+
+    for (size_t a = 0; a != count; ++a){
+        auto& qa = quads[order[a]];
+        for (size_t b = a + 1; b != count && quads[order[b]].x <= qa.x + qa.z + qa.w; ++b){
+            auto& qb = quads[order[b]];
+            const glm::int64 gap = std::max(std::max((glm::int64)qb.x - (glm::int64)(qa.x + qa.z), (glm::int64)qa.x - (glm::int64)(qb.x + qb.z)),
+                                            std::max((glm::int64)qb.y - (glm::int64)(qa.y + qa.z), (glm::int64)qa.y - (glm::int64)(qb.y + qb.z)));
+
+            if (gap <= (glm::int64)std::min(qa.w, qb.w)){
+                glm::uint64 lo = std::min(order[a], order[b]), hi = std::max(order[a], order[b]);
+                pairs.push_back(hi << 32 | lo);
+                ++first_pair[hi + 1];
+            }
+        }
+    }
+
+    // earlier steps each step conflicts with, grouped by counting
+    for (size_t i = 0; i != count; ++i){
+        first_pair[i + 1] += first_pair[i];
+    }
+    std::vector<unsigned, frame_allocator<unsigned> > conflicts(pairs.size(), 0, frame_allocator<unsigned>(m_frame_arena));
+    for (auto pair : pairs){
+        conflicts[first_pair[pair >> 32]++] = (unsigned)(pair & 0xffffffffu);
+    }
+    // shifted by one group now, first_pair[i] ends the group of step i
+
+    // Greedy in plan order, a step goes to the first set none of the steps
+    // it conflicts with took. It comes after them where their order
+    // matters: collapses, and splits next to a split of another level,
+    // which may be one it needs first.
+    std::vector<unsigned, frame_allocator<unsigned> > taken{frame_allocator<unsigned>(m_frame_arena)};
+
+    long free_nodes = (long)current->budget - (long)current->budget_filled;
+    unsigned after_collapses = 0;
+    unsigned set_count = 0;
+
+    sets.assign(count, 0);
+
+    for (size_t i = 0; i != count; ++i){
+        unsigned first = 0;
+        taken.clear();
+
+        for (unsigned c = (i ? first_pair[i - 1] : 0); c != first_pair[i]; ++c){
+            const size_t j = conflicts[c];
+
+            if (steps[i].collapse || steps[j].collapse || quads[i].z != quads[j].z)
+                first = std::max(first, sets[j] + 1);
+            else
+                taken.push_back(sets[j]);
+        }
+
+        // a split the budget lacks room for without collapses waits for
+        // the collapses before it
+        if (!steps[i].collapse){
+            free_nodes -= CHILDREN;
+            if (free_nodes < 0)
+                first = std::max(first, after_collapses);
+        }
+
+        unsigned s = first;
+        while (std::find(taken.begin(), taken.end(), s) != taken.end())
+            ++s;
+
+        sets[i] = s;
+        set_count = std::max(set_count, s + 1);
+
+        if (steps[i].collapse)
+            after_collapses = std::max(after_collapses, s + 1);
+    }
+    return set_count;
+}
+
+unsigned
+QuadtreeEngine::apply_plan_steps(QuadtreeEngine::q_tree_ptr current, const QuadtreeEngine::plan_step* steps, const size_t count,
+                                 QuadtreeEngine::frame_node_vector& held_back_nodes, QuadtreeEngine::frame_node_vector& dependend_nodes)
+{
+    std::vector<unsigned, frame_allocator<unsigned> > sets{frame_allocator<unsigned>(m_frame_arena)};
+    const unsigned set_count = color_plan_steps(current, steps, count, sets);
+
+    auto finish_chunk = [&](size_t begin, size_t end, unsigned worker){
+        for (size_t i = begin; i != end; ++i){
+            finish_split(m_split_nodes[i], worker);
+        }
+    };
+
+    unsigned applied = 0;
+    for (unsigned s = 0; s != set_count; ++s){
+        // checked as in apply_plan_step, the steps of earlier sets are
+        // done by now
+        m_split_nodes.clear();
+        for (size_t i = 0; i != count; ++i){
+            auto n = steps[i].node;
+            if (sets[i] != s)
+                continue;
+
+            if (steps[i].collapse){
+                apply_plan_step(current, steps[i], held_back_nodes, dependend_nodes);
+                continue;
+            }
+            if (!n->leaf || !splitable(n) || current->budget_filled + CHILDREN > current->budget)
+                continue;
+
+            check_neighbors_for_split(n, dependend_nodes);
+            if (dependend_nodes.empty()){
+                begin_split(n);
+                m_split_nodes.push_back(n);
+            }
+        }
+
+        m_thread_pool->parallel_for(m_split_nodes.size(), SPLIT_CHUNK, finish_chunk);
+        applied += (unsigned)m_split_nodes.size();
+        m_treeInfo.split_sets += m_split_nodes.empty() ? 0 : 1;
+    }
+    return applied;
+}
+
+void
+QuadtreeEngine::finish_plan()
+{
+    // the nodes of a plan stay alive until it is finished, later plans of
+    // the same frame must not take them for planned
+    for (auto& step : m_plan) {
+        step.node->plan_mark = 0;
+    }
+
+    m_plan.clear();
+    m_plan_step = 0;
+
+    // the plan no longer refers to the children it collapsed
+    retire_blocks(m_tree_current);
+}
+
+void
+QuadtreeEngine::optimize_current_tree(QuadtreeEngine::q_tree_ptr current){
+
+    // collapse candidates out of the heap until the end of the frame
+    auto& colap_able_heap = current->collapsible_heap;
+    frame_node_vector held_back_nodes(frame_nodes());
+
+    frame_node_vector dependend_nodes(frame_nodes());
+    dependend_nodes.reserve(NEIGHBORS + NEIGHBORS / 2);
+
+    // one plan per frame. Time sliced, the plan of the last frame is resumed
+    // and new ones follow until the deadline, which is checked per batch of
+    // steps, a chunk of splits per thread then.
+    unsigned planned_splits = 0;
+    unsigned applied_splits = 0;
+    unsigned plans = 0;
+
+    for (;;) {
+        if (m_plan_step == m_plan.size()) {
+            finish_plan();
+
+            if (plans != 0 && (!time_sliced() || deadline_passed()))
+                break;
+
+            planned_splits += following_ideal() ? plan_ideal_steps(current, m_plan)
+                                                : plan_current_tree(current, m_plan, held_back_nodes);
+            ++plans;
+
+            if (m_plan.empty())
+                break;
+        }
+
+        auto batch = time_sliced() ? (size_t)SPLIT_CHUNK * m_thread_pool->size() : (size_t)PLAN_BATCH;
+        auto count = std::min(m_plan.size() - m_plan_step, batch);
+        applied_splits += apply_plan_steps(current, m_plan.data() + m_plan_step, count, held_back_nodes, dependend_nodes);
+        m_plan_step += count;
+
+        if (time_sliced() && deadline_passed())
+            break;
+    }
+
+    m_treeInfo.planned_splits = planned_splits;
+    m_treeInfo.applied_splits = applied_splits;
+    m_treeInfo.pending_plan_steps = (unsigned)(m_plan.size() - m_plan_step);
+
+    // back in, unless a split of a child took them out of the candidates
+    for (auto& n : held_back_nodes) {
+        if (colap_able_heap.contains(n) || n->leaf)
+            continue;
+
+        bool children_leafs = true;
+        for (auto& c : n->child_node) {
+            children_leafs = children_leafs && c->leaf;
+        }
+        if (children_leafs) {
+            current->insert_collapsible(n);
+        }
+    }
+}
+
+
+void
+QuadtreeEngine::update_tree(){
+    
+    advance_mark_epoch(m_tree_current);
+
+    // blocks this update unlinks wait for the sections begun before
+    m_epochs.advance();
+
+    // following the ideal tree, the solver did the evaluation
+    if (!following_ideal()) {
+        update_priorities(m_tree_current);
+    }
+    else {
+        m_treeInfo.priority_updates = 0;
+        m_treeInfo.deferred_evaluations = 0;
+    }
+
+    // counted by plan_current_tree
+    m_treeInfo.forced_splits = 0;
+    m_treeInfo.max_forced_splits = 0;
+
+    optimize_current_tree(m_tree_current);
+
+    update_importance_map(m_tree_current);
+	
+    m_treeInfo.used_budget = m_tree_current->budget_filled;
+    
+    retire_blocks(m_tree_current);
+    m_treeInfo.retired_blocks = m_retired_blocks.size();
+
+    // all temporaries of the frame are gone
+    m_treeInfo.frame_arena_bytes = m_frame_arena.used();
+    m_frame_arena.reset();
+}
@@ -0,0 +1,899 @@
+#ifndef QUADTREEENGINE_HPP
+#define QUADTREEENGINE_HPP
+
+#include <vector>
+#include <stack>
+#include <queue>
+#include <set>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <map>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <quadtree_layout.h>
+#include <frustum_classify_2d.hpp>
+#include <frame_arena.hpp>
+#include <thread_pool.hpp>
+#include <epoch_reclaim.hpp>
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#define CHILDREN 4
+#define NEIGHBORS 8
+#define MAX_FRUSTUMS 32
+#define FRUSTUM_BATCH 64
+#define EVALUATE_CHUNK 256 // nodes per task of the parallel evaluation, a multiple of FRUSTUM_BATCH
+#define PLAN_BATCH 1024 // plan steps grouped into independent sets at once
+#define SPLIT_CHUNK 4 // splits per task of an independent set
+#define PLAN_CANDIDATES 4 // split candidates weighed per split of the frame budget
+#define CHURN_FRAMES 30 // default of set_churn_frames
+#define HYSTERESIS_BAND 0.001f // defaults of set_hysteresis
+#define HYSTERESIS_RESIDENCY 0
+#define COLLAPSE_CACHE_BLOCKS 256 // default capacity of the collapsed children cache
+
+// GL-free refinement engine of the restricted quadtree.
+// Owns the tree, evaluates node priorities against the 2d view frustums
+// and splits/collapses nodes within the node budget. Rendering is done
+// by QuadtreeRenderer on top of it.
+class QuadtreeEngine
+{
+public:
+    class q_node;
+    class q_tree;
+    typedef q_node* q_node_ptr;
+    typedef q_tree* q_tree_ptr;
+
+#ifdef QUADTREE_64BIT_INDEX
+    typedef scm::data::quadtree_layout_64 layout_type;
+#else
+    typedef scm::data::quadtree_layout<> layout_type;
+#endif
+    typedef layout_type::index_type index_type;
+
+    // temporaries of one update, allocated from the frame arena
+    typedef std::vector<q_node_ptr, frame_allocator<q_node_ptr> > frame_node_vector;
+    typedef std::map<index_type, q_node_ptr, std::less<index_type>,
+        frame_allocator<std::pair<const index_type, q_node_ptr> > > frame_leaf_map;
+
+    struct TreeInfo{
+        unsigned max_budget;
+        unsigned used_budget;
+        unsigned used_ideal_budget; // nodes of the ideal tree, see set_ideal_solver
+
+        size_t memory_usage;
+
+        float puffer_size;
+
+        unsigned max_depth;
+
+        float min_importance;
+        float max_importance;
+        float min_error;
+        float max_error;
+        float min_prio;
+        float max_prio;
+
+        size_t time_new_tree_update;     // microseconds the ideal tree took to solve
+        size_t time_current_tree_update; // microseconds of the last update()
+
+        glm::uvec2 page_dim;
+        glm::uvec2 ref_dim;
+
+        glm::vec2 ref_pos;
+        glm::vec2 ref_pos_trans;
+
+        size_t pool_blocks_used;
+        size_t pool_blocks_capacity;
+
+        float global_error;
+        float global_error_difference;
+
+        unsigned priority_updates; // nodes re-evaluated in the last update()
+
+        // neighbors the splits planned by the last update() forced to
+        // split first (2:1 restriction), in total and of the worst request
+        unsigned forced_splits;
+        unsigned max_forced_splits;
+
+        // splits the planner of the last update() chose, forced ones
+        // included, and those that still fit when they were applied
+        unsigned planned_splits;
+        unsigned applied_splits;
+
+        // independent sets the applied splits came in, see apply_plan_steps
+        unsigned split_sets;
+
+        // with a frame time budget: plan steps left for the next update()
+        // and outdated leafs whose evaluation was put off
+        unsigned pending_plan_steps;
+        unsigned deferred_evaluations;
+
+        // collapses of the last update() that undid a split of the last
+        // churn frames updates, see set_churn_frames
+        unsigned churned_splits;
+
+        // splits of the last update() that took their children from the
+        // collapse cache and those that did not, blocks in the cache
+        unsigned collapse_cache_hits;
+        unsigned collapse_cache_misses;
+        size_t collapse_cache_blocks;
+
+        // with the ideal solver: leafs of only one of the current and the
+        // ideal tree, and updates since the views the ideal tree is for
+        unsigned ideal_distance;
+        unsigned ideal_age;
+
+        // blocks unlinked by updates that read sections still may reach
+        size_t retired_blocks;
+
+        size_t heap_allocations;   // in the last update(), see heap_allocation_count
+        size_t frame_arena_bytes;  // temporaries of the last update()
+
+    };
+
+    class q_node_pool;
+
+    class q_node{
+
+    public:
+        // marks hold the mark epoch of the engine that set them, see is_marked
+        typedef glm::uint32 mark_type;
+
+        ~q_node(){
+            // done in cleanup of cleaunp container
+        };
+
+        index_type node_id;
+        bool leaf;
+        unsigned depth;
+        float importance;
+        float error;
+        float priority;
+        float updated_priority;
+        q_node_ptr parent;
+        q_node_ptr child_node[CHILDREN];
+
+        q_tree_ptr tree;
+
+        bool valid;
+        mark_type checked_mark;
+        mark_type plan_mark;
+
+        // position in the node pool, stable for the lifetime of the pool
+        q_node_pool* pool;
+        glm::uint32 slot;
+
+        // position in the dense leaf array and the collapsible heap of
+        // the tree, invalid_index if the node is not in there
+        glm::uint32 leaf_index;
+        glm::uint32 collapsible_index;
+
+        // position in the split heap, invalid_index if not queued
+        glm::uint32 heap_index;
+
+        // entry of the collapsed children of the node in the collapse
+        // cache of the tree, invalid_index if they are not kept
+        glm::uint32 cache_index;
+
+        // the priority stays within the engine tolerance until the
+        // accumulated view/camera motion of the engine passes these marks
+        float valid_view_motion;
+        float valid_camera_motion;
+
+        // frustum classification, one bit per view, valid while
+        // frustum_frame matches the engine; neither bit means intersecting
+        glm::uint32 frustum_frame;
+        glm::uint32 frustum_inside;
+        glm::uint32 frustum_outside;
+
+        // update of the last split or collapse of the node, 0 if there was
+        // none since it was allocated
+        glm::uint32 changed_frame;
+
+        static const glm::uint32 invalid_index = 0xffffffff;
+
+        q_node()
+        : pool(nullptr),
+        slot(0)
+        {
+            reset();
+        }
+
+        // default state, keeps pool and slot
+        void reset();
+
+        // leafs covering the cells next to a leaf, slots 0..NEIGHBORS-1 of
+        // get_neighbor_node, nullptr outside the tree. Patched by
+        // split_node/collapse_node, stale while the node is no leaf. Stored
+        // per slot in the pool, away from the attributes the scans read.
+        q_node_ptr& neighbor_node(const unsigned nbr) { return pool->m_neighbor_node[slot * NEIGHBORS + nbr]; }
+        q_node_ptr neighbor_node(const unsigned nbr) const { return pool->m_neighbor_node[slot * NEIGHBORS + nbr]; }
+
+        // the priority for read sections. Once a section can reach the
+        // node, update() writes its priority only with store_shared, so the
+        // load here sees the value before or after a write, never a torn
+        // one. priority and the other attributes are plain fields, valid
+        // on other threads only outside of update().
+        float shared_priority() const { return load_shared(priority); }
+
+        bool operator<(const q_node& rhs) const { return priority < rhs.priority; }
+        bool operator>(const q_node& rhs) const { return priority > rhs.priority; }
+
+    };
+
+    // Fixed-capacity node storage. Sibling quads are handed out and taken
+    // back as one block of CHILDREN consecutive nodes, freed blocks are
+    // recycled through a free list. Capacity is reserved up front from the
+    // tree budget; a further slab is only added if the reserve runs out,
+    // which keeps node pointers stable. Every node owns a slot id.
+    class q_node_pool{
+        friend class q_node;
+
+    public:
+        q_node_pool();
+        ~q_node_pool();
+
+        void reserve(const size_t block_count);
+
+        q_node_ptr allocate_block();
+        void free_block(q_node_ptr block);
+
+        size_t capacity() const { return m_capacity; }     // blocks
+        size_t blocks_used() const { return m_blocks_used; }
+        glm::uint32 slot_count() const { return (glm::uint32)(m_capacity * CHILDREN); }
+
+        // bytes of node storage per slot
+        static size_t bytes_per_node();
+
+    private:
+        q_node_pool(const q_node_pool&);
+        q_node_pool& operator=(const q_node_pool&);
+
+        void add_slab(const size_t block_count);
+
+        std::vector<q_node_ptr> m_slabs;
+        std::vector<q_node_ptr> m_free_blocks;
+        size_t m_slab_blocks;
+        size_t m_capacity;
+        size_t m_blocks_used;
+
+        std::vector<q_node_ptr> m_neighbor_node;
+    };
+
+    // Indexed 4-ary max heap on the node priority, or min heap with
+    // min_heap set. Every queued node keeps its position in the given index
+    // member, so a node whose priority was changed in place is moved with
+    // update() in O(log n) instead of re-sorting the whole queue.
+    class q_node_heap{
+    public:
+        explicit q_node_heap(glm::uint32 q_node::* index = &q_node::heap_index, const bool min_heap = false)
+        : m_index(index),
+        m_sign(min_heap ? -1.0f : 1.0f)
+        {}
+
+        // replaces the content, heapifies in O(n). Allocates only when
+        // count exceeds the reserved capacity.
+        void build(const q_node_ptr* nodes, const size_t count);
+        void clear();
+        void reserve(const size_t capacity) { m_entries.reserve(capacity); }
+
+        bool empty() const { return m_entries.empty(); }
+        size_t size() const { return m_entries.size(); }
+        bool contains(const q_node_ptr n) const { return n->*m_index != q_node::invalid_index; }
+
+        q_node_ptr top() const { return m_entries.front().node; }
+        q_node_ptr pop();
+        void push(q_node_ptr n);
+        void erase(q_node_ptr n);
+
+        // restores the order after the priority of n was changed
+        void update(q_node_ptr n);
+
+    private:
+        static const size_t ARITY = 4;
+
+        // the key is cached next to the pointer, sifting does not touch
+        // nodes. It is the priority, negated for a min heap.
+        struct entry{
+            float key;
+            q_node_ptr node;
+        };
+
+        float key(const q_node_ptr n) const { return m_sign * n->priority; }
+
+        void sift_up(size_t i);
+        void sift_down(size_t i);
+        void place(const size_t i, const entry& e);
+
+        std::vector<entry> m_entries;
+        glm::uint32 q_node::* m_index;
+        float m_sign;
+    };
+
+    // Sibling blocks of collapsed nodes, kept with their evaluation for a
+    // re-split of the node. Bounded, the least recently collapsed entry is
+    // evicted first. An entry is found through the cache_index of the
+    // collapsed node instead of a lookup by node id; the cached nodes may
+    // hold entries of their own collapsed children.
+    class q_collapse_cache{
+    public:
+        q_collapse_cache();
+
+        // drops the entries, the blocks are not returned to any pool
+        void reserve(const size_t capacity);
+
+        size_t capacity() const { return m_entries.size(); }
+        size_t size() const { return m_size; }
+        bool full() const { return m_size == m_entries.size(); }
+        bool contains(const q_node_ptr n) const { return n->cache_index != q_node::invalid_index; }
+
+        // the cached children of n, nullptr if there are none
+        q_node_ptr block(const q_node_ptr n) const { return contains(n) ? m_entries[n->cache_index].block : nullptr; }
+        // node of the least recently collapsed entry
+        q_node_ptr oldest() const { return m_size ? m_entries[m_oldest].node : nullptr; }
+
+        // keeps the children of n, the cache must not be full
+        void push(q_node_ptr n, q_node_ptr block);
+        // removes the entry of n and returns its children
+        q_node_ptr take(q_node_ptr n);
+
+    private:
+        // list from the oldest to the newest entry, free entries are
+        // chained through next
+        struct entry{
+            q_node_ptr node;
+            q_node_ptr block;
+            glm::uint32 prev;
+            glm::uint32 next;
+        };
+
+        std::vector<entry> m_entries;
+        size_t m_size;
+        glm::uint32 m_oldest;
+        glm::uint32 m_newest;
+        glm::uint32 m_free;
+    };
+
+    // Open addressing hash of the leafs of a tree keyed by node id, linear
+    // probing with backward shift deletion. Neighbor queries find the leaf
+    // covering a position with a few lookups around the level of the node,
+    // so no raster of the finest level is needed.
+    class q_leaf_table{
+    public:
+        q_leaf_table();
+
+        // room for count leafs without rehashing
+        void reserve(const size_t count);
+        void clear();
+
+        size_t size() const { return m_size; }
+        size_t capacity() const { return m_entries.size(); }
+
+        void insert(q_node_ptr n);
+        void erase(const q_node_ptr n);
+
+        // leaf with the node id, nullptr if there is none
+        q_node_ptr find(const index_type node_id) const;
+
+    private:
+        struct entry{
+            index_type node_id;
+            q_node_ptr node;
+        };
+
+        size_t bucket(const index_type node_id) const;
+        void rehash(const size_t capacity);
+
+        std::vector<entry> m_entries;
+        size_t m_size;
+        unsigned m_shift;
+    };
+
+    class q_tree{
+    public:
+        q_node_ptr root_node;
+        unsigned max_depth;
+        unsigned budget;
+        unsigned frame_budget;
+        unsigned budget_filled;
+        bool strict;
+
+        q_node_pool node_pool;
+
+        // Dense array of all leafs, kept up to date by split_node/collapse_node.
+        // Removal swaps in the last element, so the order is arbitrary.
+        std::vector<q_node_ptr> leaf_nodes;
+
+        // inner nodes whose children are all leafs, lowest priority on top.
+        // Kept across frames, split_node/collapse_node add and remove the
+        // candidates and update_priorities moves them on re-evaluation.
+        q_node_heap collapsible_heap{&q_node::collapsible_index, true};
+
+        // the leafs again, by node id
+        q_leaf_table leaf_table;
+
+        // children of recently collapsed nodes, see split_node
+        q_collapse_cache collapse_cache;
+
+        void insert_leaf(q_node_ptr n) { if (insert_dense(leaf_nodes, n, &q_node::leaf_index)) leaf_table.insert(n); }
+        void erase_leaf(q_node_ptr n) { if (erase_dense(leaf_nodes, n, &q_node::leaf_index)) leaf_table.erase(n); }
+        void insert_collapsible(q_node_ptr n) { if (!collapsible_heap.contains(n)) collapsible_heap.push(n); }
+        void erase_collapsible(q_node_ptr n) { if (collapsible_heap.contains(n)) collapsible_heap.erase(n); }
+
+        // rasters of the finest level, only allocated and kept up to date
+        // while the engine visualization is enabled
+        std::vector<char> qtree_depth_data; //visulizing only
+        std::vector<unsigned> qtree_id_data; //visulizing only
+        std::vector<float> qtree_importance_data; //visulizing only
+
+        std::vector<unsigned char> get_id_data_rgb() const{
+            std::vector<unsigned char> rgb_index_data;
+            rgb_index_data.resize(qtree_id_data.size() * 3);
+
+            return rgb_index_data;
+        }
+
+    private:
+        static bool insert_dense(std::vector<q_node_ptr>& dense, q_node_ptr n, glm::uint32 q_node::* index){
+            if (n->*index != q_node::invalid_index)
+                return false;
+            n->*index = (glm::uint32)dense.size();
+            dense.push_back(n);
+            return true;
+        }
+
+        static bool erase_dense(std::vector<q_node_ptr>& dense, q_node_ptr n, glm::uint32 q_node::* index){
+            auto i = n->*index;
+            if (i == q_node::invalid_index)
+                return false;
+            dense[i] = dense.back();
+            dense[i]->*index = i;
+            dense.pop_back();
+            n->*index = q_node::invalid_index;
+            return true;
+        }
+    };
+
+    class frustrum_2d {
+    public:
+        glm::vec2         m_camera_point;
+        glm::vec2         m_camera_point_trans;
+
+        glm::vec2         m_frustrum_points[2];
+        glm::vec2         m_frustrum_points_trans[2];
+    };
+
+    struct greater_prio_ptr
+    {
+        inline bool operator()(const QuadtreeEngine::q_node_ptr& lhs,
+        const QuadtreeEngine::q_node_ptr& rhs) const {
+            return lhs->priority > rhs->priority;
+        }
+    }; // struct greater_prio_ptr
+
+    struct lesser_prio_ptr
+    {
+        inline bool operator()(const QuadtreeEngine::q_node_ptr& lhs,
+        const QuadtreeEngine::q_node_ptr& rhs) const {
+            return lhs->priority < rhs->priority;
+        }
+    }; // struct lesser_prio_ptr
+
+public:
+    QuadtreeEngine(const unsigned budget = 2000, const unsigned max_depth = 7);
+    ~QuadtreeEngine();
+
+    // placement of the unit tree square in the space of the frustum points
+    void set_model(const glm::mat4& model);
+    void set_splits_per_frame(const int splits_per_frame);
+
+    // milliseconds an update() may spend on evaluating and refining the
+    // tree. Work past the deadline is resumed by the next update(), one
+    // batch of evaluations and one plan step always run. 0 limits the
+    // refinement by the splits per frame only.
+    void set_frame_time_budget(const float milliseconds);
+
+    // A collapse only pays for a split whose priority gain exceeds the
+    // priority of the collapsed node by the relative band, and nodes are
+    // neither collapsed nor split again within residency_frames updates of
+    // their last split or collapse.
+    void set_hysteresis(const float band, const unsigned residency_frames);
+
+    // a collapse of a node split within this many updates counts as a
+    // churned split in the TreeInfo, it does not change the refinement
+    void set_churn_frames(const unsigned frames);
+
+    // sibling blocks of collapsed nodes kept for a re-split, 0 frees the
+    // children right away
+    void set_collapse_cache(const unsigned blocks);
+
+    // workers the priority evaluation of update() is spread over, nullptr
+    // evaluates on the calling thread. Defaults to thread_pool::shared(),
+    // the results do not depend on the number of threads.
+    void set_thread_pool(thread_pool* pool);
+
+    // Solves the ideal tree, the whole budget split by priority at once,
+    // on a thread of its own from the views of the latest update(). The
+    // current tree then no longer evaluates priorities, each update() plans
+    // up to the splits per frame of splits and of collapses towards the
+    // latest ideal tree instead. Until the first one is solved the tree is
+    // refined as usual.
+    void set_ideal_solver(const bool enabled);
+    bool get_ideal_solver() const { return m_ideal_thread.joinable(); }
+
+    // relative priority change a node may accumulate from camera motion
+    // before it is re-evaluated, 0 re-evaluates on any motion
+    void set_priority_tolerance(const float tolerance);
+
+    // keeps the depth/id/importance rasters of the finest level of the
+    // current tree up to date for display, 4^max_depth texels each
+    void set_visualization(const bool enabled);
+    bool get_visualization() const { return m_visualization; }
+
+    // node marks of the last update, set while they hold the current epoch
+    bool is_marked(const q_node::mark_type mark) const { return mark == m_mark_epoch; }
+
+    // runs one refinement step of the current tree against the given views
+    // (camera and frustum points in model space) and returns the frame stats
+    TreeInfo update(const std::vector<frustrum_2d>& views);
+
+    const TreeInfo& get_tree_info() const { return m_treeInfo; }
+    const std::vector<frustrum_2d>& get_frustrums() const { return m_frustrum_2d_vec; }
+    q_tree_ptr get_current_tree() const { return m_tree_current; }
+    unsigned get_tree_resolution() const { return m_tree_resolution; }
+
+    const std::vector<q_node_ptr>& get_leaf_nodes() const;
+
+    // Reads the current tree from any thread while another one runs
+    // update(), without locks. Nodes reached in a section stay valid until
+    // it ends: blocks that splits and collapses unlink go back to the pool
+    // only once every section that began before has ended. A section sees
+    // each child link and priority either before or after a change, not
+    // the tree of one update as a whole. Nothing else of a node may be
+    // read in a section, see q_node::shared_priority. Up to
+    // EPOCH_READER_SLOTS sections at the same time, all ended before the
+    // engine is destroyed.
+    class read_section{
+    public:
+        explicit read_section(const QuadtreeEngine& engine);
+        ~read_section();
+
+        q_node_ptr root() const;
+        // child c of n, nullptr while n is a leaf
+        q_node_ptr child(const q_node_ptr n, const unsigned c) const;
+        float priority(const q_node_ptr n) const { return n->shared_priority(); }
+
+        // leaf over the cell of the finest level and its depth, the node
+        // id follows from get_layout().node_index
+        q_node_ptr find_leaf(const glm::uvec2& cell, unsigned& depth) const;
+
+    private:
+        read_section(const read_section&);
+        read_section& operator=(const read_section&);
+
+        const QuadtreeEngine& m_engine;
+        unsigned m_slot;
+    };
+
+    // splits leafs breadth first down to the given depth or until the
+    // budget is used up, to start benchmarks from a populated tree
+    void split_to_depth(const unsigned depth);
+
+    bool check_frustrum(const unsigned frust_nbr, glm::vec2 pos) const;
+    // the same against a view that need not be the engine's
+    static bool check_frustrum(const frustrum_2d& view, glm::vec2 pos);
+
+    const layout_type& get_layout() const { return q_layout; }
+
+private:
+
+    // split_node is begin_split and finish_split in one. begin_split
+    // changes the tree structure and must run alone, finish_split of
+    // splits far enough apart (see color_plan_steps) may run concurrently.
+    void split_node(q_node_ptr n);
+    void begin_split(q_node_ptr n);
+    void finish_split(q_node_ptr n, const unsigned worker);
+    void collapse_node(q_node_ptr n);
+    // drops the cached children of n and of the nodes among them
+    void evict_cached_children(q_tree_ptr tree, q_node_ptr n);
+    // retires cleanup_container, frees what no read section can reach any
+    // more once no plan is pending
+    void retire_blocks(q_tree_ptr tree);
+    bool splitable(q_node_ptr n) const;
+    bool collabsible(q_node_ptr n) const;
+
+    // the results live until the end of the frame
+    frame_leaf_map get_all_current_leafs(QuadtreeEngine::q_tree_ptr tree);
+    frame_allocator<q_node_ptr> frame_nodes() { return frame_allocator<q_node_ptr>(m_frame_arena); }
+
+    // fill caller buffers, usually frame_nodes() backed
+    void get_splitable_nodes(QuadtreeEngine::q_tree_ptr t, frame_node_vector& nodes) const;
+    const std::vector<q_node_ptr>& get_leaf_nodes(QuadtreeEngine::q_tree_ptr t) const;
+    void get_leaf_nodes_with_depth_outside(QuadtreeEngine::q_tree_ptr t, const unsigned depth, frame_node_vector& nodes) const;
+
+    // cached links of leafs, get_neighbor_node looks the neighbor up in
+    // the leaf table. With QUADTREE_CHECK_NEIGHBOR_LINKS every cached
+    // answer is asserted against the lookup.
+    q_node_ptr get_cached_neighbor_node(const q_node_ptr n, const unsigned neighbor_nbr) const;
+    q_node_ptr get_neighbor_node(const q_node_ptr n, const q_tree_ptr tree, const unsigned neighbor_nbr) const;
+    bool get_neighbor_cell(const q_node_ptr n, const q_tree_ptr tree, const unsigned neighbor_nbr, glm::uvec2& cell) const;
+    q_node_ptr find_leaf(const q_tree_ptr tree, const glm::uvec2& cell, const unsigned depth) const;
+    q_node_ptr find_leaf_below(const q_node_ptr n, const glm::uvec2& cell) const;
+    // after n was split or collapsed, links of the leafs in and around n.
+    // Only the links of leafs touching n change.
+    struct border_ring;
+    void link_neighbors(const q_node_ptr n, border_ring& ring);
+    void link_neighbor_slots(const q_node_ptr n, q_node_ptr l, const border_ring& ring);
+    void check_neighbors_for_level_div(const q_node_ptr n, const float level_div, frame_node_vector& nodes) const;
+    void check_neighbors_for_split(const q_node_ptr n, frame_node_vector& nodes) const;
+    void check_neighbors_for_collapse(const q_node_ptr n, frame_node_vector& nodes) const;
+    void check_neighbors_for_restricted(const q_node_ptr n, frame_node_vector& nodes) const;
+    q_tree_ptr init_tree() const;
+    void delete_tree(q_tree_ptr tree);
+    void reserve_node_pool(q_tree_ptr tree);
+    void optimize_current_tree(q_tree_ptr src);
+
+    // Refinement of one frame is planned before it is applied. The top
+    // split candidates come with the coarser neighbors they force to split
+    // (their closure), which count with at least the priority of the
+    // candidate, and are taken greedily by priority gain per split,
+    // up to frame_budget candidates; collapses of cheaper candidates pay for
+    // the nodes the budget lacks. The plan mark only tells the plan being
+    // made which nodes it took, it expires with the frame like all marks.
+    // With a frame time budget a plan may span frames, its steps are
+    // checked again when they are applied.
+    struct plan_candidate{
+        float gain;         // mean priority of the closure, see get_split_gain
+        unsigned version;   // planned closures when the gain was computed
+        q_node_ptr node;
+
+        bool operator<(const plan_candidate& rhs) const { return gain < rhs.gain; }
+    };
+    struct plan_step{
+        q_node_ptr node;
+        bool collapse;
+    };
+    typedef std::vector<plan_candidate, frame_allocator<plan_candidate> > frame_candidate_vector;
+
+    unsigned plan_current_tree(q_tree_ptr current, std::vector<plan_step>& plan, frame_node_vector& held_back_nodes);
+    bool apply_plan_step(q_tree_ptr current, const plan_step& step, frame_node_vector& held_back_nodes, frame_node_vector& dependend_nodes);
+
+    // The steps are grouped into independent sets, no leaf touches the
+    // nodes of two steps of a set. The steps of a set are applied in plan
+    // order, the splits among them are finished on the thread pool.
+    // Returns the applied splits.
+    unsigned apply_plan_steps(q_tree_ptr current, const plan_step* steps, const size_t count,
+                              frame_node_vector& held_back_nodes, frame_node_vector& dependend_nodes);
+    // set of each step, returns the number of sets
+    unsigned color_plan_steps(const q_tree_ptr current, const plan_step* steps, const size_t count, std::vector<unsigned, frame_allocator<unsigned> >& sets);
+    void finish_plan();
+
+    // the plan towards the ideal tree: collapses of the nodes it does not
+    // split, then the leafs it splits further with their closures, coarsest
+    // first. Returns the planned splits.
+    unsigned plan_ideal_steps(q_tree_ptr current, std::vector<plan_step>& plan);
+    bool following_ideal() const { return m_ideal_frame != 0; }
+    bool get_split_closure(const q_node_ptr n, const unsigned max_splits, frame_node_vector& closure, frame_node_vector& dependend_nodes) const;
+    float get_split_gain(const q_node_ptr n, const frame_node_vector& closure) const;
+    q_node_ptr plan_collapse(q_tree_ptr current, const float gain, frame_node_vector& held_back_nodes, frame_node_vector& dependend_nodes);
+    bool planned_split(const q_node_ptr n) const;
+    bool planned_collapse(const q_node_ptr n) const;
+    bool resident(const q_node_ptr n) const;
+
+    void update_tree();
+    bool time_sliced() const { return m_frame_time_budget > 0.0f; }
+    bool deadline_passed() const;
+    void update_priorities(q_tree_ptr m_tree);
+    void advance_mark_epoch(q_tree_ptr m_tree);
+    void update_importance_map(q_tree_ptr m_tree);
+    void resize_rasters(q_tree_ptr tree);
+    void rasterize_node(const q_node_ptr n);
+    void update_tree_info(q_tree_ptr m_tree);
+    void set_max_neigbor_priorities(q_tree_ptr m_tree);
+
+    float get_importance_of_node(q_node_ptr n) const;
+    float get_error_of_node(q_node_ptr n) const;
+
+    // the terms of a node visible in the views of the set bits, shared
+    // with the ideal solver
+    float get_importance(const index_type node_id, const glm::uint32 visible, const std::vector<frustrum_2d>& views) const;
+    float get_error(const unsigned depth, const unsigned max_depth, const bool visible) const;
+    static float get_priority(const float importance, const float error);
+
+    // importance, error and priority of n, plus the motion it stays valid for
+    void evaluate_node(q_node_ptr n);
+    // spread over the thread pool in chunks of EVALUATE_CHUNK nodes
+    void evaluate_nodes(const q_node_ptr* nodes, const size_t count);
+    // time sliced, stops after the step that passed the deadline and
+    // returns how many of the nodes it evaluated
+    size_t evaluate_nodes_until(const q_node_ptr* nodes, const size_t count,
+                                const std::chrono::high_resolution_clock::time_point& deadline);
+    bool priority_outdated(const q_node_ptr n) const;
+    void invalidate_priority(q_node_ptr n);
+    float get_view_motion_bound(const q_node_ptr n) const;
+    float get_camera_motion_bound(const q_node_ptr n) const;
+    void accumulate_view_motion(const std::vector<frustrum_2d>& previous_views);
+    void reset_view_motion(q_tree_ptr tree);
+
+    // cached per frame, see classify_frustrums
+    bool check_frustrum(q_node_ptr pos) const;
+    bool check_frustrum(const unsigned frust_nbr, q_node_ptr pos) const;
+
+    void get_node_corners(const q_node_ptr n, glm::vec2 corners[4]) const;
+    void get_node_quad(const q_node_ptr n, float& x, float& y, float& size) const;
+    void update_frustum_planes();
+    void classify_frustrums(q_node_ptr n) const;
+    struct quad_batch;
+    // children of parent, if given, take what its classification of this
+    // frame decides and only the undecided ones go through the kernel
+    void classify_frustrums(const q_node_ptr* nodes, const size_t count, quad_batch& batch,
+                            const q_node_ptr parent = nullptr);
+    glm::uint32 all_frustums() const { return all_frustums(m_frustum_planes.size()); }
+    static glm::uint32 all_frustums(const size_t count) { return count >= 32 ? 0xffffffffu : ((1u << count) - 1u); }
+
+    // summed over the chunks of the leafs in chunk order
+    double get_global_error(const std::vector<q_node_ptr>& leafs);
+
+    bool is_node_inside_tree(q_node_ptr node, q_tree_ptr tree);
+    bool is_child_node_inside_tree(q_node_ptr node, q_tree_ptr tree);
+
+    // Ideal solver. The worker thread only touches the tree it solves,
+    // its own scratch and the constant parts of the engine; finished trees
+    // and the views are handed over under m_ideal_mutex.
+    struct ideal_scratch{
+        std::vector<frustrum_2d>       views;
+        std::vector<frustum_planes_2d> planes;
+        glm::uint32                    frame;
+        q_node_heap                    heap;
+        std::vector<q_node_ptr>        closure;
+        std::vector<q_node_ptr>        blocks;
+    };
+    void run_ideal_solver();
+    void solve_ideal_tree(q_tree_ptr tree, ideal_scratch& s) const;
+    void split_ideal_node(q_node_ptr n, ideal_scratch& s) const;
+    void evaluate_ideal_node(q_node_ptr n, const ideal_scratch& s) const;
+    void post_ideal_views();
+    void take_ideal_tree();
+    unsigned get_ideal_distance(const q_tree_ptr current, const q_tree_ptr ideal);
+
+    TreeInfo          m_treeInfo;
+
+    unsigned int      m_tree_resolution;
+    bool              m_visualization;
+
+    std::vector<frustrum_2d>     m_frustrum_2d_vec;
+    std::vector<frustrum_2d>     m_previous_frustrum_2d_vec;
+
+    // bump arena of the temporaries of update(), reset at the end of update_tree
+    frame_arena       m_frame_arena;
+
+    // see set_frame_time_budget, the deadlines are set by update()
+    float             m_frame_time_budget;
+    std::chrono::high_resolution_clock::time_point m_evaluation_deadline;
+    std::chrono::high_resolution_clock::time_point m_frame_deadline;
+
+    // refinement plan and its next step, kept while it spans frames
+    std::vector<plan_step> m_plan;
+    size_t            m_plan_step;
+
+    // leaf index the evaluations of the next time sliced update() start at
+    size_t            m_evaluate_cursor;
+
+    // see set_hysteresis, m_frame counts the updates from 1
+    float             m_hysteresis_band;
+    unsigned          m_residency_frames;
+    unsigned          m_churn_frames;
+    glm::uint32       m_frame;
+
+    // motion of the views summed over the frames: the largest displacement
+    // of any camera/frustum point in model space, and of any camera in tree
+    // space. Reset together with all node marks once m_priorities_outdated.
+    float             m_view_motion;
+    float             m_camera_motion;
+    float             m_priority_tolerance;
+    bool              m_priorities_outdated;
+
+    // stamp of the node frustum classifications, bumped whenever the views
+    // or the model change
+    glm::uint32       m_frustum_frame;
+
+    // a node mark is set while it equals the epoch, one increment per
+    // update clears all marks of the tree
+    q_node::mark_type m_mark_epoch;
+
+    // views in tree space for classify_quads_2d
+    std::vector<frustum_planes_2d> m_frustum_planes;
+
+    // batch classification scratch, structure of arrays
+    struct quad_batch{
+        std::vector<q_node_ptr>  nodes;
+        std::vector<index_type>  ids;
+        std::vector<glm::uvec2>  positions;
+        std::vector<float>       x;
+        std::vector<float>       y;
+        std::vector<float>       size;
+        std::vector<glm::uint32> inside;
+        std::vector<glm::uint32> outside;
+    };
+
+    // see set_thread_pool, one classification scratch per worker
+    thread_pool*             m_thread_pool;
+    std::vector<quad_batch>  m_quad_batches;
+
+    // global error of each chunk of the leafs, see get_global_error
+    std::vector<double>      m_error_sums;
+
+    // nodes to re-evaluate in update_priorities
+    std::vector<q_node_ptr>  m_evaluate_nodes;
+
+    // leafs around a split/collapsed node and their cells (corner, size)
+    // on the finest level, see link_neighbors. One per worker.
+    struct border_ring{
+        std::vector<q_node_ptr>  nodes;
+        std::vector<glm::uvec3>  cells;
+        unsigned                 shift;
+    };
+    std::vector<border_ring> m_border_rings;
+
+    // splits of the independent set being applied
+    std::vector<q_node_ptr>  m_split_nodes;
+
+    glm::mat4         m_model;
+    glm::mat4         m_model_inverse;
+
+    q_tree_ptr m_tree_current;
+
+    layout_type       q_layout;
+
+    // blocks of collapsed children, retired once their plan is finished or
+    // at the end of update_tree, freed only between plans
+    std::vector<q_node_ptr> cleanup_container;
+
+    // see read_section, advanced by every update_tree
+    mutable epoch_domain m_epochs;
+
+    // in the order of their epochs
+    struct retired_block{
+        epoch_domain::epoch_type epoch;
+        q_node_ptr block;
+    };
+    std::vector<retired_block> m_retired_blocks;
+
+    // see set_ideal_solver. The ideal tree update() follows, solved for the
+    // views of update m_ideal_frame, 0 before the first one was taken.
+    std::thread       m_ideal_thread;
+    q_tree_ptr        m_tree_ideal;
+    glm::uint32       m_ideal_frame;
+
+    // nodes of the current and the ideal tree side by side, see get_ideal_distance
+    std::vector<q_node_ptr> m_ideal_node_pairs;
+
+    // guarded by m_ideal_mutex: the latest views with the update they are
+    // from, and the latest solved tree with the update of its views, 0
+    // once it was taken
+    std::mutex        m_ideal_mutex;
+    std::condition_variable m_ideal_posted;
+    std::vector<frustrum_2d> m_ideal_views;
+    std::vector<frustum_planes_2d> m_ideal_planes;
+    glm::uint32       m_ideal_views_frame;
+    q_tree_ptr        m_tree_ideal_ready;
+    glm::uint32       m_ideal_ready_frame;
+    size_t            m_ideal_ready_time;
+    bool              m_ideal_stop;
+
+    // the tree the worker solves, swapped with m_tree_ideal_ready once done
+    q_tree_ptr        m_tree_ideal_build;
+
+};
+
+
+#endif // define QUADTREEENGINE_HPP
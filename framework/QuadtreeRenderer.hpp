@@ -2,29 +2,25 @@
 #define QUADTREERENDERER_HPP
 
 #include "data_types_fwd.hpp"
+#include "QuadtreeEngine.hpp"
+#include "latest_slot.hpp"
+#include "spsc_queue.hpp"
 
 #include <vector>
-#include <stack>
-#include <queue>
-#include <set>
-#include <algorithm>
-#include <functional>
 #include <memory>
 #include <iostream>
 #include <stdlib.h> 
-
-#include <quadtree_layout.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <string>
-#include <map>
 
 #define GLM_FORCE_RADIANS
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
-#define CHILDREN 4
-#define NEIGHBORS 8
-
 
 namespace helper {
 
@@ -137,146 +133,22 @@ namespace helper {
 
 class QuadtreeRenderer
 {
-    class q_node;
-    class q_tree;
-    typedef q_node* q_node_ptr;
-    typedef q_tree* q_tree_ptr;
+    typedef QuadtreeEngine::q_node_ptr q_node_ptr;
+    typedef QuadtreeEngine::frustrum_2d frustrum_2d;
 
 public:
-    struct TreeInfo{
-        unsigned max_budget;
-        unsigned used_budget;
-        unsigned used_ideal_budget;
-
-        size_t memory_usage;
-
-        float puffer_size;
-
-        unsigned max_depth;
+    typedef QuadtreeEngine::TreeInfo TreeInfo;
 
-        float min_importance;
-		float max_importance;
-		float min_error;
-		float max_error;
-        float min_prio;
-        float max_prio;
-        
-        size_t time_new_tree_update;
-        size_t time_current_tree_update;
-
-        glm::uvec2 page_dim;
-        glm::uvec2 ref_dim;
-
-        glm::vec2 ref_pos;
-        glm::vec2 ref_pos_trans;
-
-        float global_error;
-        float global_error_difference;
-            
-    } m_treeInfo;
+    TreeInfo m_treeInfo;
 
     struct Vertex{
         glm::vec3 position;
         glm::vec3 color;
     };
-        
-    class q_node{
-
-    public:
-        ~q_node(){
-            // done in cleanup of cleaunp container
-            for (unsigned c = 0; c != CHILDREN; ++c){
-                //parent->child_node[c] = nullptr;
-                //if (child_node[c]){
-                //    delete child_node[c];
-                //    child_node[c] = nullptr;
-                //}
-            }
-        };
-
-        unsigned node_id;        
-        bool leaf;
-        unsigned depth;
-        float importance;
-        float error;
-        float priority;
-        float updated_priority;
-        q_node_ptr parent;
-        q_node_ptr child_node[CHILDREN];
-
-        q_tree_ptr tree;
-
-        bool valid;
-        bool dependend_mark;
-		bool split_mark;
-		bool checked_mark;
-
-        q_node(){            
-            leaf = false;
-            depth = 0;
-            importance = 0.0;
-            error = 0.0;
-            priority = 0.0;
-            valid = true;
-
-            dependend_mark = false;
-
-            parent = nullptr;
-
-            for (unsigned c = 0; c != CHILDREN; ++c){
-                child_node[c] = nullptr;
-            }
-        }
-
-        bool operator<(const q_node& rhs) const { priority < rhs.priority; }
-        bool operator>(const q_node& rhs) const { priority > rhs.priority; }
-		
-    };
-
-	struct less_than_priority
-	{
-		inline bool operator() (const q_node_ptr& struct1, const q_node_ptr& struct2)
-	{
-		return (struct1->priority < struct2->priority);
-	}
-	};
-
-    class q_tree{
-    public:
-        q_node_ptr root_node;  
-        unsigned max_depth;
-        unsigned budget;
-        unsigned frame_budget;
-        unsigned budget_filled;        
-        bool strict;
-        
-        std::vector<q_node_ptr> qtree_index_data;
-        std::vector<char> qtree_depth_data; //visulizing only
-        std::vector<unsigned> qtree_id_data; //visulizing only
-        std::vector<float> qtree_importance_data; //visulizing only
-
-        std::vector<unsigned char> get_id_data_rgb() const{
-            std::vector<unsigned char> rgb_index_data;
-            rgb_index_data.resize(qtree_id_data.size() * 3);
-
-            auto counter = 0;
-            return rgb_index_data;
-        }
-        
-    };
-            
-	class frustrum_2d {
-		public:
-			glm::vec2         m_camera_point;
-			glm::vec2         m_camera_point_trans;
-
-			glm::vec2         m_frustrum_points[2];
-			glm::vec2         m_frustrum_points_trans[2];
-	};
 
 public:
     QuadtreeRenderer();
-    ~QuadtreeRenderer() {}
+    ~QuadtreeRenderer();
 
 	void reload_shader();
 
@@ -286,70 +158,79 @@ public:
     void set_frustum(const unsigned frust_nr, glm::vec2 camera_point, glm::vec2 restriction_line[2]);
     void set_test_point(glm::vec2 test_point); 
 	void set_splits_per_frame(const int splits_per_frame);
+	void set_frame_time_budget(const float milliseconds);
+	void set_hysteresis(const float band, const unsigned residency_frames);
+	void set_churn_frames(const unsigned frames);
+	void set_collapse_cache(const unsigned blocks);
+	void set_ideal_solver(const bool enabled);
+
+	// Posts the views to the update thread and draws the latest leaf set it
+	// finished, without waiting for an update. The settings above reach
+	// the engine with the next posted views.
     void update_and_draw(std::vector<glm::vec2> screen_pos, glm::uvec2 screen_dim);
 
-
-    
-    struct greater_prio_ptr : public std::binary_function<QuadtreeRenderer::q_node_ptr,
-        QuadtreeRenderer::q_node_ptr, bool>
-    {
-        inline bool operator()(const QuadtreeRenderer::q_node_ptr& lhs,
-        const QuadtreeRenderer::q_node_ptr& rhs) const {
-            return lhs->priority > rhs->priority;
-        }
-    }; // struct greater_prio_ptr
-
-    struct lesser_prio_ptr: public std::binary_function<QuadtreeRenderer::q_node_ptr,
-        QuadtreeRenderer::q_node_ptr, bool>
-    {
-        inline bool operator()(const QuadtreeRenderer::q_node_ptr& lhs,
-        const QuadtreeRenderer::q_node_ptr& rhs) const {
-            return lhs->priority < rhs->priority;
-        }
-    }; // struct greater_prio_ptr
+	// draw calls since the views of the drawn leaf set were posted
+	unsigned get_update_lag() const { return m_posted_views - m_drawn_views; }
 
 private:
 
-    void split_node(q_node_ptr n);
-    void collapse_node(q_node_ptr n);
-    bool splitable(q_node_ptr n) const;
-    bool collabsible(q_node_ptr n) const;
-
-    std::map<unsigned, q_node_ptr> get_all_current_leafs(QuadtreeRenderer::q_tree_ptr tree) const;
-
-    std::vector<q_node_ptr> get_splitable_nodes(QuadtreeRenderer::q_tree_ptr t) const;
-    std::vector<q_node_ptr> get_collabsible_nodes(QuadtreeRenderer::q_tree_ptr t) const;
-    void set_collabsible_nodes_priorities(QuadtreeRenderer::q_tree_ptr t);
-    std::vector<q_node_ptr> get_leaf_nodes(QuadtreeRenderer::q_tree_ptr t) const;
-    std::vector<q_node_ptr> get_leaf_nodes_with_depth_outside(QuadtreeRenderer::q_tree_ptr t, const unsigned depth) const;
-
-    void resolve_dependencies_priorities(const q_node_ptr n, int& counter);
-
-    q_node_ptr get_neighbor_node(const q_node_ptr n, const q_tree_ptr tree, const unsigned neighbor_nbr) const;
-    std::vector<q_node_ptr> check_neighbors_for_level_div(const q_node_ptr n, const float level_div) const;
-    std::vector<q_node_ptr> check_neighbors_for_split(const q_node_ptr n) const;
-    std::vector<q_node_ptr> check_and_mark_neighbors_for_split(const q_node_ptr n);
-    std::vector<q_node_ptr> check_neighbors_for_collapse(const q_node_ptr n) const;
-    std::vector<q_node_ptr> check_neighbors_for_restricted(const q_node_ptr n) const;
-    void init_tree(q_tree_ptr dst);
-    void optimize_current_tree(q_tree_ptr src);
-    
-    void update_vbo();
-    void update_tree();    
-    void update_priorities(q_tree_ptr m_tree);
-    void clear_tree_marks(q_tree_ptr m_tree);
-    void update_importance_map(q_tree_ptr m_tree);
-    void set_max_neigbor_priorities(q_tree_ptr m_tree);
-    
-    float get_importance_of_node(q_node_ptr n) const;
-    float get_error_of_node(q_node_ptr n) const;
+	// engine settings and views of one update, from the render thread
+	struct update_request{
+		unsigned  views_nbr;
+		glm::mat4 model;
+		std::vector<frustrum_2d> views;
+		int       splits_per_frame;
+		float     frame_time_budget;
+		float     hysteresis_band;
+		unsigned  residency_frames;
+		unsigned  churn_frames;
+		unsigned  collapse_cache_blocks;
+		bool      ideal_solver;
+	};
 
-	bool check_frustrum(q_node_ptr pos) const;
-	bool check_frustrum(const unsigned frust_nbr, q_node_ptr pos) const;
-    bool check_frustrum(const unsigned frust_nbr, glm::vec2 pos) const;
+	// leaf set of one finished update, from the update thread
+	struct update_frame{
+		unsigned  views_nbr;
+		TreeInfo  info;
+		std::vector<QuadtreeRenderer::Vertex> leaf_vertices;
+		std::vector<QuadtreeRenderer::Vertex> priority_vertices;
+		std::vector<float> importance_data;
+	};
 
-    bool is_node_inside_tree(q_node_ptr node, q_tree_ptr tree);
-    bool is_child_node_inside_tree(q_node_ptr node, q_tree_ptr tree);
+	void run_updates();
+	void wake_updates();
+	void build_leaf_vertices(update_frame& frame) const;
+
+	void update_leaf_vbo();
+	void update_vbo();
+
+    QuadtreeEngine    m_engine;
+
+	// owned by the update thread while it runs, the render thread only
+	// touches the engine before it starts and after it stopped
+	std::thread       m_update_thread;
+	std::atomic<bool> m_stop_updates;
+
+	// set with views the update thread may be waiting for, a frame handed
+	// back or the stop, the update thread waits for it once it has nothing
+	// to do
+	std::mutex        m_update_mutex;
+	std::condition_variable m_update_posted;
+	bool              m_update_pending;
+
+	// the render thread posts views and hands back drawn frames, the update
+	// thread publishes finished frames. Views not taken yet are replaced by
+	// newer ones. One frame is drawn, one is being filled, the third lets
+	// the update thread run ahead of a slow draw.
+	update_request    m_request;
+	std::vector<update_frame> m_frames;
+	update_frame*     m_frame;
+	latest_slot<update_request>   m_requests;
+	spsc_queue<update_frame*, 3>  m_free_frames;
+	spsc_queue<update_frame*, 3>  m_ready_frames;
+
+	unsigned          m_posted_views;
+	unsigned          m_drawn_views;
 
     unsigned int      m_tree_resolution;
 
@@ -380,30 +261,16 @@ private:
     
 	std::vector<frustrum_2d>	 m_frustrum_2d_vec;
 
-    /*glm::vec2         m_camera_point;
-    glm::vec2         m_camera_point_trans;
-
-    glm::vec2         m_frustrum_points[2];
-    glm::vec2         m_frustrum_points_trans[2];*/
-
     glm::vec2         m_test_point;
     glm::vec2         m_test_point_trans;
 
     glm::mat4         m_model;
     glm::mat4         m_model_inverse;
-    
-    q_tree_ptr m_tree_current;
 
-    std::vector<QuadtreeRenderer::Vertex> m_cubeVertices;
-    std::vector<QuadtreeRenderer::Vertex> m_cubeVertices_i;
     std::vector<glm::vec3> m_quadVertices;
 
     bool              m_dirty;
 
-    scm::data::quadtree_layout q_layout;
-
-    std::vector<q_node_ptr> cleanup_container;
-
 	std::string quad_fragment_shader_string = "../../../framework/shader/quad_shader.frag";
 	std::string quad_vertex_shader_string = "../../../framework/shader/quad_shader.vert";
 
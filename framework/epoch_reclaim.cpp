@@ -0,0 +1,63 @@
+// -----------------------------------------------------------------------------
+// Epoch based reclamation of memory read without locks
+// -----------------------------------------------------------------------------
+
+#include "epoch_reclaim.hpp"
+
+#include <thread>
+
+epoch_domain::epoch_domain()
+: m_epoch(1)
+{
+    for (auto& s : m_slots){
+        s.epoch.store(0, std::memory_order_relaxed);
+    }
+}
+
+unsigned
+epoch_domain::enter()
+{
+    for (;;){
+        // a stale epoch only holds back more objects than necessary
+        const epoch_type epoch = m_epoch.load(std::memory_order_relaxed);
+
+        for (unsigned s = 0; s != EPOCH_READER_SLOTS; ++s){
+            epoch_type free_slot = 0;
+            if (m_slots[s].epoch.load(std::memory_order_relaxed) == 0
+                && m_slots[s].epoch.compare_exchange_strong(free_slot, epoch)){
+                // pairs with the fence of safe_epoch: a writer that misses
+                // the slot unlinked its objects before the reads that follow
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                return s;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+void
+epoch_domain::leave(const unsigned slot)
+{
+    // the reads of the section come before the reuse of what they reached
+    m_slots[slot].epoch.store(0, std::memory_order_release);
+}
+
+void
+epoch_domain::advance()
+{
+    m_epoch.store(m_epoch.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+epoch_domain::epoch_type
+epoch_domain::safe_epoch() const
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    epoch_type safe = m_epoch.load(std::memory_order_relaxed) + 1;
+    for (auto& s : m_slots){
+        const epoch_type epoch = s.epoch.load(std::memory_order_acquire);
+        if (epoch != 0 && epoch < safe)
+            safe = epoch;
+    }
+    return safe;
+}
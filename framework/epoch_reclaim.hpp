@@ -0,0 +1,82 @@
+#ifndef EPOCH_RECLAIM_HPP
+#define EPOCH_RECLAIM_HPP
+
+// -----------------------------------------------------------------------------
+// Epoch based reclamation of memory read without locks
+//
+// One writer unlinks objects from a structure that readers traverse at the
+// same time and retires them with the current epoch. A reader announces the
+// epoch it begins in, in a slot of its own, and clears the slot when done.
+// The writer advances the epoch once per update and reuses a retired object
+// only once no reader announces an epoch at or before the one it was retired
+// in, every reader that could have reached it has left by then. Beginning
+// and ending a read takes no lock: one exchange on a free slot and a store.
+//
+// load_shared/store_shared access the plain fields readers and the writer
+// share: single-copy atomic, a load acquires what the store of the same
+// field released, a pointer read so sees the object it was published with.
+// -----------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+
+#define EPOCH_READER_SLOTS 64 // read sections of a domain at the same time
+
+class epoch_domain
+{
+public:
+    typedef unsigned long long epoch_type;
+
+    epoch_domain();
+
+    // reader side: announces the current epoch in a free slot and returns
+    // it for leave, waits while all slots are taken
+    unsigned enter();
+    void leave(const unsigned slot);
+
+    // writer side. Objects retired with an epoch below safe_epoch() are out
+    // of reach of all readers.
+    epoch_type epoch() const { return m_epoch.load(std::memory_order_relaxed); }
+    void advance();
+    epoch_type safe_epoch() const;
+
+private:
+    epoch_domain(const epoch_domain&);
+    epoch_domain& operator=(const epoch_domain&);
+
+    // one cache line per slot, epoch 0 marks a free one
+    struct reader_slot{
+        std::atomic<epoch_type> epoch;
+        char padding[64 - sizeof(std::atomic<epoch_type>)];
+    };
+
+    std::atomic<epoch_type> m_epoch;
+    reader_slot m_slots[EPOCH_READER_SLOTS];
+};
+
+template <typename T>
+inline T
+load_shared(const T& field)
+{
+#if defined(_MSC_VER)
+    // volatile accesses acquire and release with /volatile:ms
+    return *static_cast<const volatile T*>(&field);
+#else
+    T value;
+    __atomic_load(&field, &value, __ATOMIC_ACQUIRE);
+    return value;
+#endif
+}
+
+template <typename T>
+inline void
+store_shared(T& field, T value)
+{
+#if defined(_MSC_VER)
+    *static_cast<volatile T*>(&field) = value;
+#else
+    __atomic_store(&field, &value, __ATOMIC_RELEASE);
+#endif
+}
+
+#endif // EPOCH_RECLAIM_HPP
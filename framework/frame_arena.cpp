@@ -0,0 +1,143 @@
+// -----------------------------------------------------------------------------
+// Bump allocation of the temporaries of one engine frame
+// -----------------------------------------------------------------------------
+
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+namespace {
+
+std::atomic<size_t> g_heap_allocations(0);
+
+void*
+heap_allocate(const size_t bytes)
+{
+    ++g_heap_allocations;
+
+    void* p = std::malloc(bytes ? bytes : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+size_t
+align_up(const size_t offset, const size_t alignment)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+#if defined(QUADTREE_COUNT_ALLOCATIONS)
+// new[] and delete[] forward to these
+void*
+operator new(size_t bytes)
+{
+    return heap_allocate(bytes);
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+#endif
+
+size_t
+heap_allocation_count()
+{
+    return g_heap_allocations;
+}
+
+frame_arena::frame_arena(const size_t block_size)
+: m_block(nullptr),
+m_block_size(block_size),
+m_offset(0),
+m_overflow(nullptr),
+m_overflow_offset(0),
+m_overflow_bytes(0),
+m_used(0)
+{
+    m_block = static_cast<char*>(heap_allocate(m_block_size));
+}
+
+frame_arena::~frame_arena()
+{
+    while (m_overflow){
+        auto next = m_overflow->next;
+        std::free(m_overflow);
+        m_overflow = next;
+    }
+    std::free(m_block);
+}
+
+void*
+frame_arena::allocate(const size_t bytes, const size_t alignment)
+{
+    m_used += bytes;
+
+    // the block itself is malloc aligned
+    size_t offset = align_up(m_offset, alignment);
+    if (offset + bytes <= m_block_size){
+        m_offset = offset + bytes;
+        return m_block + offset;
+    }
+
+    return allocate_overflow(bytes, alignment);
+}
+
+char*
+frame_arena::allocate_overflow(const size_t bytes, const size_t alignment)
+{
+    const size_t header = align_up(sizeof(overflow_block), alignof(std::max_align_t));
+
+    if (m_overflow){
+        size_t offset = align_up(m_overflow_offset, alignment);
+        if (offset + bytes <= m_overflow->size){
+            m_overflow_offset = offset + bytes;
+            return reinterpret_cast<char*>(m_overflow) + offset;
+        }
+    }
+
+    // at least as large as everything so far, the blocks double up
+    size_t size = header + bytes + alignment;
+    size = std::max(size, m_block_size + m_overflow_bytes);
+
+    auto block = static_cast<overflow_block*>(heap_allocate(size));
+    block->next = m_overflow;
+    block->size = size;
+
+    m_overflow = block;
+    m_overflow_bytes += size;
+
+    size_t offset = align_up(header, alignment);
+    m_overflow_offset = offset + bytes;
+    return reinterpret_cast<char*>(block) + offset;
+}
+
+void
+frame_arena::reset()
+{
+    m_offset = 0;
+    m_used = 0;
+
+    if (!m_overflow)
+        return;
+
+    // one block large enough for the whole last frame
+    while (m_overflow){
+        auto next = m_overflow->next;
+        std::free(m_overflow);
+        m_overflow = next;
+    }
+
+    m_block_size += m_overflow_bytes;
+    m_overflow_offset = 0;
+    m_overflow_bytes = 0;
+
+    std::free(m_block);
+    m_block = static_cast<char*>(heap_allocate(m_block_size));
+}
@@ -0,0 +1,87 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+// -----------------------------------------------------------------------------
+// Bump allocation of the temporaries of one engine frame
+//
+// Containers of a frame take their memory from a frame_arena through
+// frame_allocator; nothing is given back until the arena is reset at the
+// end of the frame. A frame that outgrows the block of the arena spills into
+// overflow blocks, which are merged into one larger block at the next reset,
+// so a steady frame loop runs out of a single block without touching the
+// heap.
+// -----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <new>
+
+class frame_arena
+{
+public:
+    explicit frame_arena(const size_t block_size = 64 * 1024);
+    ~frame_arena();
+
+    void* allocate(const size_t bytes, const size_t alignment);
+
+    // gives back everything allocated since the last reset
+    void reset();
+
+    size_t capacity() const { return m_block_size; }
+    size_t used() const { return m_used; }
+
+private:
+    frame_arena(const frame_arena&);
+    frame_arena& operator=(const frame_arena&);
+
+    struct overflow_block{
+        overflow_block* next;
+        size_t size;
+    };
+
+    char* allocate_overflow(const size_t bytes, const size_t alignment);
+
+    char* m_block;
+    size_t m_block_size;
+    size_t m_offset;
+
+    overflow_block* m_overflow;
+    size_t m_overflow_offset;
+    size_t m_overflow_bytes;
+
+    size_t m_used;
+};
+
+// std allocator on top of a frame_arena, deallocate is a no-op
+template <typename T>
+class frame_allocator
+{
+public:
+    typedef T value_type;
+
+    explicit frame_allocator(frame_arena& arena) : m_arena(&arena) {}
+
+    template <typename U>
+    frame_allocator(const frame_allocator<U>& other) : m_arena(other.arena()) {}
+
+    T* allocate(const size_t count) {
+        return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, const size_t) {}
+
+    frame_arena* arena() const { return m_arena; }
+
+    template <typename U>
+    bool operator==(const frame_allocator<U>& rhs) const { return m_arena == rhs.arena(); }
+    template <typename U>
+    bool operator!=(const frame_allocator<U>& rhs) const { return m_arena != rhs.arena(); }
+
+private:
+    frame_arena* m_arena;
+};
+
+// heap allocations of the process so far. With QUADTREE_COUNT_ALLOCATIONS
+// the global operator new is replaced to count all of them, otherwise only
+// the blocks the frame arenas take from the heap are counted.
+size_t heap_allocation_count();
+
+#endif // FRAME_ARENA_HPP
@@ -0,0 +1,354 @@
+// -----------------------------------------------------------------------------
+// Batched classification of quadtree node quads against 2d view frustums
+// (no OpenGL dependency)
+// -----------------------------------------------------------------------------
+
+#include "frustum_classify_2d.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/geometric.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FRUSTUM_CLASSIFY_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// the simd kernels are compiled for their instruction set only, the rest of
+// the library keeps the baseline flags
+#if defined(FRUSTUM_CLASSIFY_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FRUSTUM_CLASSIFY_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FRUSTUM_CLASSIFY_TARGET(isa)
+#endif
+
+frustum_planes_2d
+make_frustum_planes_2d(const glm::vec2& c, const glm::vec2& f1, const glm::vec2& f2, const glm::mat4& model)
+{
+    // model space p = A q + t for tree space q
+    const float a00 = model[0][0];
+    const float a01 = model[1][0];
+    const float a10 = model[0][1];
+    const float a11 = model[1][1];
+    const glm::vec2 t(model[3][0], model[3][1]);
+
+    // normals of the point test in QuadtreeEngine::check_frustrum
+    glm::vec2 n1 = c - f1;
+    n1 = glm::vec2(-n1.y, n1.x);
+    glm::vec2 n2 = f2 - c;
+    n2 = glm::vec2(-n2.y, n2.x);
+
+    // n . (A q + t - c) = (A^T n) . q + n . (t - c)
+    frustum_planes_2d p;
+    p.n1x = a00 * n1.x + a10 * n1.y;
+    p.n1y = a01 * n1.x + a11 * n1.y;
+    p.d1 = glm::dot(n1, t - c);
+    p.neg1 = std::min(p.n1x, 0.0f) + std::min(p.n1y, 0.0f);
+    p.pos1 = std::max(p.n1x, 0.0f) + std::max(p.n1y, 0.0f);
+
+    p.n2x = a00 * n2.x + a10 * n2.y;
+    p.n2y = a01 * n2.x + a11 * n2.y;
+    p.d2 = glm::dot(n2, t - c);
+    p.neg2 = std::min(p.n2x, 0.0f) + std::min(p.n2y, 0.0f);
+    p.pos2 = std::max(p.n2x, 0.0f) + std::max(p.n2y, 0.0f);
+
+    const float inf = std::numeric_limits<float>::infinity();
+    p.min_x = -inf;
+    p.max_x = inf;
+    p.min_y = -inf;
+    p.max_y = inf;
+
+    // the wedge is spanned by the edge rays from the camera; they bound it
+    // along an axis if both point the same way. Parallel planes or a
+    // singular model leave it unbounded, the plane tests still hold.
+    const float det = a00 * a11 - a01 * a10;
+    const float cross = n1.x * n2.y - n1.y * n2.x;
+
+    if (det == 0.0f || cross == 0.0f)
+        return p;
+
+    glm::vec2 r1 = f1 - c;
+    if (glm::dot(n2, r1) < 0.0f)
+        r1 = -r1;
+    glm::vec2 r2 = f2 - c;
+    if (glm::dot(n1, r2) < 0.0f)
+        r2 = -r2;
+
+    // to tree space, A^-1
+    const glm::vec2 ct = c - t;
+    const glm::vec2 apex((a11 * ct.x - a01 * ct.y) / det, (a00 * ct.y - a10 * ct.x) / det);
+    const glm::vec2 ray1((a11 * r1.x - a01 * r1.y) / det, (a00 * r1.y - a10 * r1.x) / det);
+    const glm::vec2 ray2((a11 * r2.x - a01 * r2.y) / det, (a00 * r2.y - a10 * r2.x) / det);
+
+    if (ray1.x >= 0.0f && ray2.x >= 0.0f)
+        p.min_x = apex.x;
+    else if (ray1.x <= 0.0f && ray2.x <= 0.0f)
+        p.max_x = apex.x;
+
+    if (ray1.y >= 0.0f && ray2.y >= 0.0f)
+        p.min_y = apex.y;
+    else if (ray1.y <= 0.0f && ray2.y <= 0.0f)
+        p.max_y = apex.y;
+
+    return p;
+}
+
+namespace {
+
+void
+classify_quads_scalar(const frustum_planes_2d* frustums, const unsigned frustum_count,
+                      const float* x, const float* y, const float* size, const size_t quad_count,
+                      glm::uint32* inside, glm::uint32* outside)
+{
+    for (size_t i = 0; i != quad_count; ++i){
+        const float qx = x[i];
+        const float qy = y[i];
+        const float qs = size[i];
+        const float qx_end = qx + qs;
+        const float qy_end = qy + qs;
+
+        glm::uint32 in = 0;
+        glm::uint32 out = 0;
+
+        for (unsigned f = 0; f != frustum_count; ++f){
+            const frustum_planes_2d& p = frustums[f];
+
+            const float base1 = p.n1x * qx + p.n1y * qy + p.d1;
+            const float base2 = p.n2x * qx + p.n2y * qy + p.d2;
+            const float lo1 = base1 + qs * p.neg1;
+            const float hi1 = base1 + qs * p.pos1;
+            const float lo2 = base2 + qs * p.neg2;
+            const float hi2 = base2 + qs * p.pos2;
+
+            const bool is_in = lo1 > 0.0f && lo2 > 0.0f;
+            const bool is_out = hi1 < 0.0f || hi2 < 0.0f
+                || qx > p.max_x || qx_end < p.min_x
+                || qy > p.max_y || qy_end < p.min_y;
+
+            in |= glm::uint32(is_in) << f;
+            out |= glm::uint32(is_out) << f;
+        }
+
+        inside[i] = in;
+        outside[i] = out;
+    }
+}
+
+#if defined(FRUSTUM_CLASSIFY_X86)
+
+FRUSTUM_CLASSIFY_TARGET("sse4.1")
+void
+classify_quads_sse4(const frustum_planes_2d* frustums, const unsigned frustum_count,
+                    const float* x, const float* y, const float* size, const size_t quad_count,
+                    glm::uint32* inside, glm::uint32* outside)
+{
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 4 <= quad_count; i += 4){
+        const __m128 qx = _mm_loadu_ps(x + i);
+        const __m128 qy = _mm_loadu_ps(y + i);
+        const __m128 qs = _mm_loadu_ps(size + i);
+        const __m128 qx_end = _mm_add_ps(qx, qs);
+        const __m128 qy_end = _mm_add_ps(qy, qs);
+
+        __m128 in = zero;
+        __m128 out = zero;
+
+        for (unsigned f = 0; f != frustum_count; ++f){
+            const frustum_planes_2d& p = frustums[f];
+
+            const __m128 base1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.n1x), qx), _mm_mul_ps(_mm_set1_ps(p.n1y), qy)), _mm_set1_ps(p.d1));
+            const __m128 base2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.n2x), qx), _mm_mul_ps(_mm_set1_ps(p.n2y), qy)), _mm_set1_ps(p.d2));
+            const __m128 lo1 = _mm_add_ps(base1, _mm_mul_ps(qs, _mm_set1_ps(p.neg1)));
+            const __m128 hi1 = _mm_add_ps(base1, _mm_mul_ps(qs, _mm_set1_ps(p.pos1)));
+            const __m128 lo2 = _mm_add_ps(base2, _mm_mul_ps(qs, _mm_set1_ps(p.neg2)));
+            const __m128 hi2 = _mm_add_ps(base2, _mm_mul_ps(qs, _mm_set1_ps(p.pos2)));
+
+            const __m128 is_in = _mm_and_ps(_mm_cmpgt_ps(lo1, zero), _mm_cmpgt_ps(lo2, zero));
+            const __m128 is_out = _mm_or_ps(
+                _mm_or_ps(_mm_cmplt_ps(hi1, zero), _mm_cmplt_ps(hi2, zero)),
+                _mm_or_ps(
+                    _mm_or_ps(_mm_cmpgt_ps(qx, _mm_set1_ps(p.max_x)), _mm_cmplt_ps(qx_end, _mm_set1_ps(p.min_x))),
+                    _mm_or_ps(_mm_cmpgt_ps(qy, _mm_set1_ps(p.max_y)), _mm_cmplt_ps(qy_end, _mm_set1_ps(p.min_y)))));
+
+            // lane masks select the frustum bit
+            const __m128 bit = _mm_castsi128_ps(_mm_set1_epi32((int)(1u << f)));
+            in = _mm_or_ps(in, _mm_and_ps(is_in, bit));
+            out = _mm_or_ps(out, _mm_and_ps(is_out, bit));
+        }
+
+        _mm_storeu_si128((__m128i*)(inside + i), _mm_castps_si128(in));
+        _mm_storeu_si128((__m128i*)(outside + i), _mm_castps_si128(out));
+    }
+
+    classify_quads_scalar(frustums, frustum_count, x + i, y + i, size + i, quad_count - i, inside + i, outside + i);
+}
+
+FRUSTUM_CLASSIFY_TARGET("avx2")
+void
+classify_quads_avx2(const frustum_planes_2d* frustums, const unsigned frustum_count,
+                    const float* x, const float* y, const float* size, const size_t quad_count,
+                    glm::uint32* inside, glm::uint32* outside)
+{
+    // no fma, so every path rounds exactly like the scalar one
+    const __m256 zero = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 8 <= quad_count; i += 8){
+        const __m256 qx = _mm256_loadu_ps(x + i);
+        const __m256 qy = _mm256_loadu_ps(y + i);
+        const __m256 qs = _mm256_loadu_ps(size + i);
+        const __m256 qx_end = _mm256_add_ps(qx, qs);
+        const __m256 qy_end = _mm256_add_ps(qy, qs);
+
+        __m256 in = zero;
+        __m256 out = zero;
+
+        for (unsigned f = 0; f != frustum_count; ++f){
+            const frustum_planes_2d& p = frustums[f];
+
+            const __m256 base1 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.n1x), qx), _mm256_mul_ps(_mm256_set1_ps(p.n1y), qy)), _mm256_set1_ps(p.d1));
+            const __m256 base2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.n2x), qx), _mm256_mul_ps(_mm256_set1_ps(p.n2y), qy)), _mm256_set1_ps(p.d2));
+            const __m256 lo1 = _mm256_add_ps(base1, _mm256_mul_ps(qs, _mm256_set1_ps(p.neg1)));
+            const __m256 hi1 = _mm256_add_ps(base1, _mm256_mul_ps(qs, _mm256_set1_ps(p.pos1)));
+            const __m256 lo2 = _mm256_add_ps(base2, _mm256_mul_ps(qs, _mm256_set1_ps(p.neg2)));
+            const __m256 hi2 = _mm256_add_ps(base2, _mm256_mul_ps(qs, _mm256_set1_ps(p.pos2)));
+
+            const __m256 is_in = _mm256_and_ps(_mm256_cmp_ps(lo1, zero, _CMP_GT_OQ), _mm256_cmp_ps(lo2, zero, _CMP_GT_OQ));
+            const __m256 is_out = _mm256_or_ps(
+                _mm256_or_ps(_mm256_cmp_ps(hi1, zero, _CMP_LT_OQ), _mm256_cmp_ps(hi2, zero, _CMP_LT_OQ)),
+                _mm256_or_ps(
+                    _mm256_or_ps(_mm256_cmp_ps(qx, _mm256_set1_ps(p.max_x), _CMP_GT_OQ), _mm256_cmp_ps(qx_end, _mm256_set1_ps(p.min_x), _CMP_LT_OQ)),
+                    _mm256_or_ps(_mm256_cmp_ps(qy, _mm256_set1_ps(p.max_y), _CMP_GT_OQ), _mm256_cmp_ps(qy_end, _mm256_set1_ps(p.min_y), _CMP_LT_OQ))));
+
+            const __m256 bit = _mm256_castsi256_ps(_mm256_set1_epi32((int)(1u << f)));
+            in = _mm256_or_ps(in, _mm256_and_ps(is_in, bit));
+            out = _mm256_or_ps(out, _mm256_and_ps(is_out, bit));
+        }
+
+        _mm256_storeu_si256((__m256i*)(inside + i), _mm256_castps_si256(in));
+        _mm256_storeu_si256((__m256i*)(outside + i), _mm256_castps_si256(out));
+    }
+
+    // the tail and the caller run legacy sse code, which stalls on dirty
+    // upper ymm halves on most cpus
+    _mm256_zeroupper();
+
+    classify_quads_sse4(frustums, frustum_count, x + i, y + i, size + i, quad_count - i, inside + i, outside + i);
+}
+
+bool
+cpu_supports(const frustum_kernel_2d kernel)
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    const bool ymm_state = osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+
+    switch (kernel){
+    case FRUSTUM_KERNEL_SSE4: return sse41;
+    case FRUSTUM_KERNEL_AVX2: return sse41 && ymm_state && avx2;
+    default: return true;
+    }
+#else
+    __builtin_cpu_init();
+
+    switch (kernel){
+    case FRUSTUM_KERNEL_SSE4: return __builtin_cpu_supports("sse4.1") != 0;
+    case FRUSTUM_KERNEL_AVX2: return __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("avx2");
+    default: return true;
+    }
+#endif
+}
+
+#else
+
+bool
+cpu_supports(const frustum_kernel_2d kernel)
+{
+    return kernel == FRUSTUM_KERNEL_SCALAR;
+}
+
+#endif // FRUSTUM_CLASSIFY_X86
+
+frustum_kernel_2d
+best_kernel()
+{
+    if (cpu_supports(FRUSTUM_KERNEL_AVX2))
+        return FRUSTUM_KERNEL_AVX2;
+    if (cpu_supports(FRUSTUM_KERNEL_SSE4))
+        return FRUSTUM_KERNEL_SSE4;
+    return FRUSTUM_KERNEL_SCALAR;
+}
+
+frustum_kernel_2d&
+current_kernel()
+{
+    static frustum_kernel_2d kernel = best_kernel();
+    return kernel;
+}
+
+} // namespace
+
+void
+classify_quads_2d(const frustum_planes_2d* frustums, const unsigned frustum_count,
+                  const float* x, const float* y, const float* size, const size_t quad_count,
+                  glm::uint32* inside, glm::uint32* outside)
+{
+    switch (current_kernel()){
+#if defined(FRUSTUM_CLASSIFY_X86)
+    case FRUSTUM_KERNEL_AVX2:
+        classify_quads_avx2(frustums, frustum_count, x, y, size, quad_count, inside, outside);
+        break;
+    case FRUSTUM_KERNEL_SSE4:
+        classify_quads_sse4(frustums, frustum_count, x, y, size, quad_count, inside, outside);
+        break;
+#endif
+    default:
+        classify_quads_scalar(frustums, frustum_count, x, y, size, quad_count, inside, outside);
+        break;
+    }
+}
+
+bool
+frustum_kernel_2d_supported(const frustum_kernel_2d kernel)
+{
+    return cpu_supports(kernel);
+}
+
+const char*
+frustum_kernel_2d_name(const frustum_kernel_2d kernel)
+{
+    switch (kernel){
+    case FRUSTUM_KERNEL_SSE4: return "sse4.1";
+    case FRUSTUM_KERNEL_AVX2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+frustum_kernel_2d
+active_frustum_kernel_2d()
+{
+    return current_kernel();
+}
+
+bool
+set_frustum_kernel_2d(const frustum_kernel_2d kernel)
+{
+    if (!cpu_supports(kernel))
+        return false;
+
+    current_kernel() = kernel;
+    return true;
+}
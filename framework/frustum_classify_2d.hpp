@@ -0,0 +1,61 @@
+#ifndef FRUSTUM_CLASSIFY_2D_HPP
+#define FRUSTUM_CLASSIFY_2D_HPP
+
+// -----------------------------------------------------------------------------
+// Batched classification of quadtree node quads against 2d view frustums
+// (no OpenGL dependency)
+//
+// A view frustum is the wedge between the two half planes through the camera
+// point and its frustum points. Planes and wedge extents are moved into the
+// unit space of the tree once, so a node quad is just its lower corner and
+// edge length. Quads are passed as structure of arrays and classified 4 (SSE4.1)
+// or 8 (AVX2) at a time; the kernel is picked from the cpu at startup.
+// -----------------------------------------------------------------------------
+
+#include <cstddef>
+
+#define GLM_FORCE_RADIANS
+#include <glm/fwd.hpp>
+#include <glm/vec2.hpp>
+#include <glm/mat4x4.hpp>
+
+struct frustum_planes_2d
+{
+    // inside of half plane i: nx * x + ny * y + d > 0, neg/pos are the sums
+    // of the negative/positive normal components to get the quad min/max
+    float n1x, n1y, d1, neg1, pos1;
+    float n2x, n2y, d2, neg2, pos2;
+
+    // extent of the wedge along the tree axes, +-inf where unbounded
+    float min_x, max_x, min_y, max_y;
+};
+
+// camera and frustum points in model space, model places the unit tree square
+frustum_planes_2d make_frustum_planes_2d(const glm::vec2& camera,
+                                         const glm::vec2& frustum_point_1,
+                                         const glm::vec2& frustum_point_2,
+                                         const glm::mat4& model);
+
+enum frustum_kernel_2d
+{
+    FRUSTUM_KERNEL_SCALAR = 0,
+    FRUSTUM_KERNEL_SSE4,
+    FRUSTUM_KERNEL_AVX2
+};
+
+// Classifies quad i = [x[i], x[i] + size[i]] x [y[i], y[i] + size[i]] against
+// all frustums. Bit f of inside[i] / outside[i] is set if the quad lies fully
+// inside / outside of frustum f, neither bit means the quad intersects it.
+// Up to 32 frustums.
+void classify_quads_2d(const frustum_planes_2d* frustums, const unsigned frustum_count,
+                       const float* x, const float* y, const float* size, const size_t quad_count,
+                       glm::uint32* inside, glm::uint32* outside);
+
+bool frustum_kernel_2d_supported(const frustum_kernel_2d kernel);
+const char* frustum_kernel_2d_name(const frustum_kernel_2d kernel);
+
+// kernel used by classify_quads_2d, returns false if the cpu lacks it
+frustum_kernel_2d active_frustum_kernel_2d();
+bool set_frustum_kernel_2d(const frustum_kernel_2d kernel);
+
+#endif // #ifndef FRUSTUM_CLASSIFY_2D_HPP
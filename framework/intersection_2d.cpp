@@ -0,0 +1,126 @@
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2014 Andreas-C. Bernstein
+// License    : MIT (see the file LICENSE)
+// Maintainer : Andreas-C. Bernstein <andreas.bernstein@uni-weimar.de>
+// Stability  : experimental
+//
+// 2d segment intersection helpers (no OpenGL dependency)
+// -----------------------------------------------------------------------------
+
+#include "intersection_2d.hpp"
+#include <cmath>
+
+#define SMALL_NUM   0.00000001 
+#define perpf(u,v)  ((u).x * (v).y - (u).y * (v).x)  // perp product  (2D)
+
+// inSegment(): determine if a glm::vec2 is inside a segment
+//    Input:  a glm::vec2 P, and a collinear segment S
+//    Return: 1 = P is inside S
+//            0 = P is  not inside S
+int
+inSegment(glm::vec2 P, glm::vec2 S_p0, glm::vec2 S_p1)
+{
+	if (S_p0.x != S_p1.x) {    // S is not  vertical
+		if (S_p0.x <= P.x && P.x <= S_p1.x)
+			return 1;
+		if (S_p0.x >= P.x && P.x >= S_p1.x)
+			return 1;
+	}
+	else {    // S is vertical, so test y  coordinate
+		if (S_p0.y <= P.y && P.y <= S_p1.y)
+			return 1;
+		if (S_p0.y >= P.y && P.y >= S_p1.y)
+			return 1;
+	}
+	return 0;
+}
+
+
+
+
+// intersect2D_2Segments(): find the 2D intersection of 2 finite segments
+//    Input:  two finite segments S1 and S2
+//    Output: *I0 = intersect point (when it exists)
+//            *I1 =  endpoint of intersect segment [I0,I1] (when it exists)
+//    Return: 0=disjoint (no intersect)
+//            1=intersect  in unique point I0
+//            2=overlap  in segment from I0 to I1
+int
+intersect2D_2Segments(glm::vec2 S1_p0, glm::vec2 S1_p1, glm::vec2 S2_p0, glm::vec2 S2_p1, glm::vec2* I0, glm::vec2* I1)
+{
+	glm::vec2    u = S1_p1 - S1_p0;
+	glm::vec2    v = S2_p1 - S2_p0;
+	glm::vec2    w = S1_p0 - S2_p0;
+	float     D = perpf(u, v);
+
+	// test if  they are parallel (includes either being a glm::vec2)
+	if (fabs(D) < SMALL_NUM) {           // S1 and S2 are parallel
+		if (perpf(u, w) != 0 || perpf(v, w) != 0) {
+			return 0;                    // they are NOT collinear
+		}
+		// they are collinear or degenerate
+		// check if they are degenerate  glm::vec2s
+		float du = glm::dot(u, u);
+		float dv = glm::dot(v, v);
+		if (du == 0 && dv == 0) {            // both segments are glm::vec2s
+			if (S1_p0 != S2_p0)         // they are distinct  glm::vec2s
+				return 0;
+			*I0 = S1_p0;                 // they are the same glm::vec2
+			return 1;
+		}
+		if (du == 0) {                     // S1 is a single glm::vec2
+			if (inSegment(S1_p0, S2_p0, S2_p1) == 0)  // but is not in S2
+				return 0;
+			*I0 = S1_p0;
+			return 1;
+		}
+		if (dv == 0) {                     // S2 a single glm::vec2
+			if (inSegment(S2_p0, S1_p0, S1_p1) == 0)  // but is not in S1
+				return 0;
+			*I0 = S2_p0;
+			return 1;
+		}
+		// they are collinear segments - get  overlap (or not)
+		float t0, t1;                    // endglm::vec2s of S1 in eqn for S2
+		glm::vec2 w2 = S1_p1 - S2_p0;
+		if (v.x != 0) {
+			t0 = w.x / v.x;
+			t1 = w2.x / v.x;
+		}
+		else {
+			t0 = w.y / v.y;
+			t1 = w2.y / v.y;
+		}
+		if (t0 > t1) {                   // must have t0 smaller than t1
+			float t = t0; t0 = t1; t1 = t;    // swap if not
+		}
+		if (t0 > 1 || t1 < 0) {
+			return 0;      // NO overlap
+		}
+		t0 = t0<0 ? 0 : t0;               // clip to min 0
+		t1 = t1>1 ? 1 : t1;               // clip to max 1
+		if (t0 == t1) {                  // intersect is a glm::vec2
+			*I0 = S2_p0 + t0 * v;
+			return 1;
+		}
+
+		// they overlap in a valid subsegment
+		*I0 = S2_p0 + t0 * v;
+		*I1 = S2_p0 + t1 * v;
+		return 2;
+	}
+
+	// the segments are skew and may intersect in a glm::vec2
+	// get the intersect parameter for S1
+	float     sI = perpf(v, w) / D;
+	if (sI < 0 || sI > 1)                // no intersect with S1
+		return 0;
+
+	// get the intersect parameter for S2
+	float     tI = perpf(u, w) / D;
+	if (tI < 0 || tI > 1)                // no intersect with S2
+		return 0;
+
+	*I0 = S1_p0 + sI * u;                // compute S1 intersect glm::vec2
+	return 1;
+}
\ No newline at end of file
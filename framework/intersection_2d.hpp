@@ -0,0 +1,20 @@
+#ifndef INTERSECTION_2D_HPP
+#define INTERSECTION_2D_HPP
+
+// -----------------------------------------------------------------------------
+// Copyright  : (C) 2014 Andreas-C. Bernstein
+// License    : MIT (see the file LICENSE)
+// Maintainer : Andreas-C. Bernstein <andreas.bernstein@uni-weimar.de>
+// Stability  : experimental
+//
+// 2d segment intersection helpers (no OpenGL dependency)
+// -----------------------------------------------------------------------------
+
+#define GLM_FORCE_RADIANS
+#include <glm/vec2.hpp>
+#include <glm/geometric.hpp>
+
+int inSegment(glm::vec2 P, glm::vec2 S_p0, glm::vec2 S_p1);
+int intersect2D_2Segments(glm::vec2 S1_p0, glm::vec2 S1_p1, glm::vec2 S2_p0, glm::vec2 S2_p1, glm::vec2* I0, glm::vec2* I1);
+
+#endif // #ifndef INTERSECTION_2D_HPP
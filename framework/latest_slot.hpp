@@ -0,0 +1,60 @@
+#ifndef LATEST_SLOT_HPP
+#define LATEST_SLOT_HPP
+
+// -----------------------------------------------------------------------------
+// Lock-free slot holding the latest value from one producer for one consumer
+//
+// Three buffers: the producer fills its own, the consumer reads its own, and
+// the third one sits between them. Publishing swaps the filled buffer into
+// the middle, taking swaps the middle out, both with one atomic exchange of
+// its index and a fresh flag. A value the consumer has not taken yet is
+// overwritten by the next one, so the consumer always gets the newest and
+// the producer never fails. Values are assigned like in spsc_queue and keep
+// their storage.
+// -----------------------------------------------------------------------------
+
+#include <atomic>
+
+template <typename T>
+class latest_slot
+{
+public:
+    latest_slot() : m_back(0), m_middle(1), m_front(2) {}
+
+    // producer only, false if it replaced a value the consumer had not
+    // taken yet
+    bool publish(const T& value) {
+        m_slots[m_back] = value;
+        const unsigned middle = m_middle.exchange(m_back | fresh, std::memory_order_acq_rel);
+        m_back = middle & ~fresh;
+        return (middle & fresh) == 0;
+    }
+
+    // consumer only, false if nothing was published since the last take
+    bool take(T& value) {
+        if ((m_middle.load(std::memory_order_relaxed) & fresh) == 0)
+            return false;
+
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~fresh;
+        value = m_slots[m_front];
+        return true;
+    }
+
+private:
+    latest_slot(const latest_slot&);
+    latest_slot& operator=(const latest_slot&);
+
+    static const unsigned fresh = 4;
+
+    T m_slots[3];
+
+    // the producer's buffer, the shared one and the consumer's buffer, apart
+    // so the two sides do not share a cache line
+    unsigned m_back;
+    char m_padding0[64];
+    std::atomic<unsigned> m_middle;
+    char m_padding1[64];
+    unsigned m_front;
+};
+
+#endif // LATEST_SLOT_HPP
@@ -0,0 +1,424 @@
+// -----------------------------------------------------------------------------
+// 2d Morton (z-order) codes of the quadtree layout
+// -----------------------------------------------------------------------------
+
+#include "morton_2d.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MORTON_2D_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// the pdep/pext kernel is compiled for bmi2 only, the rest of the library
+// keeps the baseline flags
+#if defined(MORTON_2D_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MORTON_2D_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MORTON_2D_TARGET(isa)
+#endif
+
+namespace {
+
+// former quadtree_layout::node_index and node_position loops
+
+template <typename CodeT>
+void
+encode_loop(const glm::uvec2* positions, CodeT* codes, const size_t count)
+{
+    static const unsigned max_iterations = sizeof(CodeT) * 4;
+
+    for (size_t n = 0; n != count; ++n){
+        CodeT tmp = 0;
+
+        for (unsigned i = 0; i != max_iterations; ++i){
+            const CodeT bit = (CodeT(1) << i);
+
+            tmp |= (positions[n].x & bit) << (i);
+            tmp |= (positions[n].y & bit) << (i + 1);
+        }
+        codes[n] = tmp;
+    }
+}
+
+template <typename CodeT>
+void
+decode_loop(const CodeT* codes, glm::uvec2* positions, const size_t count)
+{
+    static const unsigned max_iterations = sizeof(CodeT) * 4;
+
+    for (size_t n = 0; n != count; ++n){
+        CodeT code = codes[n];
+        glm::uvec2 tmp(0u, 0u);
+
+        for (unsigned i = 0; i != max_iterations; ++i){
+            tmp.x |= glm::uint32(code & 1u) << i;
+            tmp.y |= glm::uint32((code & 2u) >> 1) << i;
+
+            code >>= 2;
+        }
+
+        positions[n] = tmp;
+    }
+}
+
+// former disabled quadtree_layout::node_index path, the bits of a byte
+// spread to the even bits of a short
+const unsigned short MortonTable256[256] =
+{
+  0x0000, 0x0001, 0x0004, 0x0005, 0x0010, 0x0011, 0x0014, 0x0015,
+  0x0040, 0x0041, 0x0044, 0x0045, 0x0050, 0x0051, 0x0054, 0x0055,
+  0x0100, 0x0101, 0x0104, 0x0105, 0x0110, 0x0111, 0x0114, 0x0115,
+  0x0140, 0x0141, 0x0144, 0x0145, 0x0150, 0x0151, 0x0154, 0x0155,
+  0x0400, 0x0401, 0x0404, 0x0405, 0x0410, 0x0411, 0x0414, 0x0415,
+  0x0440, 0x0441, 0x0444, 0x0445, 0x0450, 0x0451, 0x0454, 0x0455,
+  0x0500, 0x0501, 0x0504, 0x0505, 0x0510, 0x0511, 0x0514, 0x0515,
+  0x0540, 0x0541, 0x0544, 0x0545, 0x0550, 0x0551, 0x0554, 0x0555,
+  0x1000, 0x1001, 0x1004, 0x1005, 0x1010, 0x1011, 0x1014, 0x1015,
+  0x1040, 0x1041, 0x1044, 0x1045, 0x1050, 0x1051, 0x1054, 0x1055,
+  0x1100, 0x1101, 0x1104, 0x1105, 0x1110, 0x1111, 0x1114, 0x1115,
+  0x1140, 0x1141, 0x1144, 0x1145, 0x1150, 0x1151, 0x1154, 0x1155,
+  0x1400, 0x1401, 0x1404, 0x1405, 0x1410, 0x1411, 0x1414, 0x1415,
+  0x1440, 0x1441, 0x1444, 0x1445, 0x1450, 0x1451, 0x1454, 0x1455,
+  0x1500, 0x1501, 0x1504, 0x1505, 0x1510, 0x1511, 0x1514, 0x1515,
+  0x1540, 0x1541, 0x1544, 0x1545, 0x1550, 0x1551, 0x1554, 0x1555,
+  0x4000, 0x4001, 0x4004, 0x4005, 0x4010, 0x4011, 0x4014, 0x4015,
+  0x4040, 0x4041, 0x4044, 0x4045, 0x4050, 0x4051, 0x4054, 0x4055,
+  0x4100, 0x4101, 0x4104, 0x4105, 0x4110, 0x4111, 0x4114, 0x4115,
+  0x4140, 0x4141, 0x4144, 0x4145, 0x4150, 0x4151, 0x4154, 0x4155,
+  0x4400, 0x4401, 0x4404, 0x4405, 0x4410, 0x4411, 0x4414, 0x4415,
+  0x4440, 0x4441, 0x4444, 0x4445, 0x4450, 0x4451, 0x4454, 0x4455,
+  0x4500, 0x4501, 0x4504, 0x4505, 0x4510, 0x4511, 0x4514, 0x4515,
+  0x4540, 0x4541, 0x4544, 0x4545, 0x4550, 0x4551, 0x4554, 0x4555,
+  0x5000, 0x5001, 0x5004, 0x5005, 0x5010, 0x5011, 0x5014, 0x5015,
+  0x5040, 0x5041, 0x5044, 0x5045, 0x5050, 0x5051, 0x5054, 0x5055,
+  0x5100, 0x5101, 0x5104, 0x5105, 0x5110, 0x5111, 0x5114, 0x5115,
+  0x5140, 0x5141, 0x5144, 0x5145, 0x5150, 0x5151, 0x5154, 0x5155,
+  0x5400, 0x5401, 0x5404, 0x5405, 0x5410, 0x5411, 0x5414, 0x5415,
+  0x5440, 0x5441, 0x5444, 0x5445, 0x5450, 0x5451, 0x5454, 0x5455,
+  0x5500, 0x5501, 0x5504, 0x5505, 0x5510, 0x5511, 0x5514, 0x5515,
+  0x5540, 0x5541, 0x5544, 0x5545, 0x5550, 0x5551, 0x5554, 0x5555
+};
+
+// the inverse, the even bits of a byte gathered to a nibble
+struct compact_table
+{
+    unsigned char value[256];
+
+    compact_table()
+    {
+        for (unsigned b = 0; b != 256; ++b){
+            value[b] = (unsigned char)morton_compact_1by1(b);
+        }
+    }
+};
+
+const compact_table& compact_table_256()
+{
+    static const compact_table table;
+    return table;
+}
+
+template <typename CodeT>
+void
+encode_table(const glm::uvec2* positions, CodeT* codes, const size_t count)
+{
+    static const unsigned bytes = sizeof(CodeT) / 2;
+
+    for (size_t n = 0; n != count; ++n){
+        CodeT tmp = 0;
+
+        for (unsigned b = 0; b != bytes; ++b){
+            tmp |= CodeT(MortonTable256[(positions[n].y >> (8 * b)) & 0xff]) << (16 * b + 1)
+                 | CodeT(MortonTable256[(positions[n].x >> (8 * b)) & 0xff]) << (16 * b);
+        }
+        codes[n] = tmp;
+    }
+}
+
+template <typename CodeT>
+void
+decode_table(const CodeT* codes, glm::uvec2* positions, const size_t count)
+{
+    static const unsigned bytes = sizeof(CodeT);
+
+    const unsigned char* compact = compact_table_256().value;
+
+    for (size_t n = 0; n != count; ++n){
+        const CodeT c = codes[n];
+        const CodeT cy = c >> 1;
+
+        glm::uvec2 tmp(0u, 0u);
+
+        for (unsigned b = 0; b != bytes; ++b){
+            tmp.x |= glm::uint32(compact[(c >> (8 * b)) & 0xff]) << (4 * b);
+            tmp.y |= glm::uint32(compact[(cy >> (8 * b)) & 0xff]) << (4 * b);
+        }
+        positions[n] = tmp;
+    }
+}
+
+template <typename CodeT>
+void
+encode_magic(const glm::uvec2* positions, CodeT* codes, const size_t count)
+{
+    for (size_t n = 0; n != count; ++n){
+        codes[n] = morton_part_1by1(CodeT(positions[n].x)) | (morton_part_1by1(CodeT(positions[n].y)) << 1);
+    }
+}
+
+template <typename CodeT>
+void
+decode_magic(const CodeT* codes, glm::uvec2* positions, const size_t count)
+{
+    for (size_t n = 0; n != count; ++n){
+        positions[n] = glm::uvec2((glm::uint32)morton_compact_1by1(codes[n]), (glm::uint32)morton_compact_1by1(CodeT(codes[n] >> 1)));
+    }
+}
+
+#if defined(MORTON_2D_X86)
+
+MORTON_2D_TARGET("bmi2")
+void
+encode_bmi2(const glm::uvec2* positions, glm::uint32* codes, const size_t count)
+{
+    for (size_t n = 0; n != count; ++n){
+        codes[n] = _pdep_u32(positions[n].x, 0x55555555u) | _pdep_u32(positions[n].y, 0xaaaaaaaau);
+    }
+}
+
+MORTON_2D_TARGET("bmi2")
+void
+decode_bmi2(const glm::uint32* codes, glm::uvec2* positions, const size_t count)
+{
+    for (size_t n = 0; n != count; ++n){
+        positions[n] = glm::uvec2(_pext_u32(codes[n], 0x55555555u), _pext_u32(codes[n], 0xaaaaaaaau));
+    }
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+MORTON_2D_TARGET("bmi2")
+void
+encode_bmi2(const glm::uvec2* positions, glm::uint64* codes, const size_t count)
+{
+    for (size_t n = 0; n != count; ++n){
+        codes[n] = _pdep_u64(positions[n].x, 0x5555555555555555ull) | _pdep_u64(positions[n].y, 0xaaaaaaaaaaaaaaaaull);
+    }
+}
+
+MORTON_2D_TARGET("bmi2")
+void
+decode_bmi2(const glm::uint64* codes, glm::uvec2* positions, const size_t count)
+{
+    for (size_t n = 0; n != count; ++n){
+        positions[n] = glm::uvec2((glm::uint32)_pext_u64(codes[n], 0x5555555555555555ull), (glm::uint32)_pext_u64(codes[n], 0xaaaaaaaaaaaaaaaaull));
+    }
+}
+#else
+// no 64 bit pdep/pext on 32 bit targets
+void
+encode_bmi2(const glm::uvec2* positions, glm::uint64* codes, const size_t count)
+{
+    encode_magic(positions, codes, count);
+}
+
+void
+decode_bmi2(const glm::uint64* codes, glm::uvec2* positions, const size_t count)
+{
+    decode_magic(codes, positions, count);
+}
+#endif
+
+void
+cpu_id(int info[4], const int leaf)
+{
+#if defined(_MSC_VER)
+    __cpuidex(info, leaf, 0);
+#else
+    unsigned a, b, c, d;
+    __cpuid_count(leaf, 0, a, b, c, d);
+    info[0] = (int)a;
+    info[1] = (int)b;
+    info[2] = (int)c;
+    info[3] = (int)d;
+#endif
+}
+
+bool
+cpu_supports(const morton_kernel_2d kernel)
+{
+    if (kernel != MORTON_KERNEL_BMI2)
+        return true;
+
+    int info[4];
+    cpu_id(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    cpu_id(info, 7);
+    return (info[1] & (1 << 8)) != 0;
+}
+
+// pdep/pext are microcoded on AMD before Zen 3 and slower than the loop
+bool
+cpu_fast_bmi2()
+{
+    int info[4];
+    cpu_id(info, 0);
+
+    char vendor[13];
+    std::memcpy(vendor, &info[1], 4);
+    std::memcpy(vendor + 4, &info[3], 4);
+    std::memcpy(vendor + 8, &info[2], 4);
+    vendor[12] = 0;
+
+    if (std::strcmp(vendor, "AuthenticAMD") != 0)
+        return true;
+
+    cpu_id(info, 1);
+    const unsigned family = ((unsigned)info[0] >> 8) & 0xf;
+    const unsigned extended_family = ((unsigned)info[0] >> 20) & 0xff;
+
+    return family + (family == 0xf ? extended_family : 0) >= 0x19;
+}
+
+#else
+
+bool
+cpu_supports(const morton_kernel_2d kernel)
+{
+    return kernel != MORTON_KERNEL_BMI2;
+}
+
+bool
+cpu_fast_bmi2()
+{
+    return false;
+}
+
+#endif // MORTON_2D_X86
+
+morton_kernel_2d
+best_kernel()
+{
+    if (cpu_supports(MORTON_KERNEL_BMI2) && cpu_fast_bmi2())
+        return MORTON_KERNEL_BMI2;
+    return MORTON_KERNEL_MAGIC;
+}
+
+morton_kernel_2d&
+current_kernel()
+{
+    static morton_kernel_2d kernel = best_kernel();
+    return kernel;
+}
+
+template <typename CodeT>
+void
+encode(const glm::uvec2* positions, CodeT* codes, const size_t count)
+{
+    switch (current_kernel()){
+#if defined(MORTON_2D_X86)
+    case MORTON_KERNEL_BMI2:
+        encode_bmi2(positions, codes, count);
+        break;
+#endif
+    case MORTON_KERNEL_LOOP:
+        encode_loop(positions, codes, count);
+        break;
+    case MORTON_KERNEL_TABLE:
+        encode_table(positions, codes, count);
+        break;
+    default:
+        encode_magic(positions, codes, count);
+        break;
+    }
+}
+
+template <typename CodeT>
+void
+decode(const CodeT* codes, glm::uvec2* positions, const size_t count)
+{
+    switch (current_kernel()){
+#if defined(MORTON_2D_X86)
+    case MORTON_KERNEL_BMI2:
+        decode_bmi2(codes, positions, count);
+        break;
+#endif
+    case MORTON_KERNEL_LOOP:
+        decode_loop(codes, positions, count);
+        break;
+    case MORTON_KERNEL_TABLE:
+        decode_table(codes, positions, count);
+        break;
+    default:
+        decode_magic(codes, positions, count);
+        break;
+    }
+}
+
+} // namespace
+
+void
+morton_encode_2d(const glm::uvec2* positions, glm::uint32* codes, const size_t count)
+{
+    encode(positions, codes, count);
+}
+
+void
+morton_decode_2d(const glm::uint32* codes, glm::uvec2* positions, const size_t count)
+{
+    decode(codes, positions, count);
+}
+
+void
+morton_encode_2d(const glm::uvec2* positions, glm::uint64* codes, const size_t count)
+{
+    encode(positions, codes, count);
+}
+
+void
+morton_decode_2d(const glm::uint64* codes, glm::uvec2* positions, const size_t count)
+{
+    decode(codes, positions, count);
+}
+
+bool
+morton_kernel_2d_supported(const morton_kernel_2d kernel)
+{
+    return cpu_supports(kernel);
+}
+
+const char*
+morton_kernel_2d_name(const morton_kernel_2d kernel)
+{
+    switch (kernel){
+    case MORTON_KERNEL_LOOP: return "loop";
+    case MORTON_KERNEL_TABLE: return "table";
+    case MORTON_KERNEL_BMI2: return "bmi2";
+    default: return "magic";
+    }
+}
+
+morton_kernel_2d
+active_morton_kernel_2d()
+{
+    return current_kernel();
+}
+
+bool
+set_morton_kernel_2d(const morton_kernel_2d kernel)
+{
+    if (!cpu_supports(kernel))
+        return false;
+
+    current_kernel() = kernel;
+    return true;
+}
@@ -0,0 +1,179 @@
+#ifndef MORTON_2D_HPP
+#define MORTON_2D_HPP
+
+// -----------------------------------------------------------------------------
+// 2d Morton (z-order) codes of the quadtree layout
+//
+// x takes the even, y the odd bits of a code; 32 bit codes hold 16 bit,
+// 64 bit codes 32 bit coordinates. The inline single value functions are
+// branch free and use BMI2 pdep/pext where the compiler targets it. The
+// batch functions convert arrays and dispatch to the fastest kernel of the
+// cpu, picked at startup.
+// -----------------------------------------------------------------------------
+
+#include <cstddef>
+
+#include <glm/fwd.hpp>
+#include <glm/vec2.hpp>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// position of the highest set bit, -1 for 0
+inline
+int
+morton_floor_log2(const glm::uint32 x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (x == 0) ? -1 : 31 - __builtin_clz(x);
+#elif defined(_MSC_VER)
+    unsigned long pos;
+    return _BitScanReverse(&pos, x) ? (int)pos : -1;
+#else
+    int pos = 0;
+    glm::uint32 v = x;
+
+    if (v & 0xffff0000u) { v >>= 16; pos += 16; }
+    if (v & 0x0000ff00u) { v >>= 8; pos += 8; }
+    if (v & 0x000000f0u) { v >>= 4; pos += 4; }
+    if (v & 0x0000000cu) { v >>= 2; pos += 2; }
+    if (v & 0x00000002u) { pos += 1; }
+
+    return (x == 0) ? -1 : pos;
+#endif
+}
+
+inline
+int
+morton_floor_log2(const glm::uint64 x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (x == 0) ? -1 : 63 - __builtin_clzll(x);
+#else
+    const glm::uint32 high = glm::uint32(x >> 32);
+    return high ? 32 + morton_floor_log2(high) : morton_floor_log2(glm::uint32(x));
+#endif
+}
+
+// spreads the low 16 bits of v to the even bits
+inline
+glm::uint32
+morton_part_1by1(glm::uint32 v)
+{
+    v &= 0x0000ffffu;
+    v = (v | (v << 8)) & 0x00ff00ffu;
+    v = (v | (v << 4)) & 0x0f0f0f0fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+// gathers the even bits of v to the low 16 bits
+inline
+glm::uint32
+morton_compact_1by1(glm::uint32 v)
+{
+    v &= 0x55555555u;
+    v = (v | (v >> 1)) & 0x33333333u;
+    v = (v | (v >> 2)) & 0x0f0f0f0fu;
+    v = (v | (v >> 4)) & 0x00ff00ffu;
+    v = (v | (v >> 8)) & 0x0000ffffu;
+    return v;
+}
+
+inline
+glm::uint32
+morton_encode_2d(const glm::uint32 x, const glm::uint32 y)
+{
+#if defined(__BMI2__)
+    return _pdep_u32(x, 0x55555555u) | _pdep_u32(y, 0xaaaaaaaau);
+#else
+    return morton_part_1by1(x) | (morton_part_1by1(y) << 1);
+#endif
+}
+
+inline
+glm::uvec2
+morton_decode_2d(const glm::uint32 code)
+{
+#if defined(__BMI2__)
+    return glm::uvec2(_pext_u32(code, 0x55555555u), _pext_u32(code, 0xaaaaaaaau));
+#else
+    return glm::uvec2(morton_compact_1by1(code), morton_compact_1by1(code >> 1));
+#endif
+}
+
+// 64 bit codes, 32 bit coordinates
+inline
+glm::uint64
+morton_part_1by1(glm::uint64 v)
+{
+    v &= 0x00000000ffffffffull;
+    v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+    v = (v | (v << 8)) & 0x00ff00ff00ff00ffull;
+    v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0full;
+    v = (v | (v << 2)) & 0x3333333333333333ull;
+    v = (v | (v << 1)) & 0x5555555555555555ull;
+    return v;
+}
+
+inline
+glm::uint64
+morton_compact_1by1(glm::uint64 v)
+{
+    v &= 0x5555555555555555ull;
+    v = (v | (v >> 1)) & 0x3333333333333333ull;
+    v = (v | (v >> 2)) & 0x0f0f0f0f0f0f0f0full;
+    v = (v | (v >> 4)) & 0x00ff00ff00ff00ffull;
+    v = (v | (v >> 8)) & 0x0000ffff0000ffffull;
+    v = (v | (v >> 16)) & 0x00000000ffffffffull;
+    return v;
+}
+
+inline
+glm::uint64
+morton_encode_2d_64(const glm::uint32 x, const glm::uint32 y)
+{
+#if defined(__BMI2__) && (defined(__x86_64__) || defined(_M_X64))
+    return _pdep_u64(x, 0x5555555555555555ull) | _pdep_u64(y, 0xaaaaaaaaaaaaaaaaull);
+#else
+    return morton_part_1by1(glm::uint64(x)) | (morton_part_1by1(glm::uint64(y)) << 1);
+#endif
+}
+
+inline
+glm::uvec2
+morton_decode_2d(const glm::uint64 code)
+{
+#if defined(__BMI2__) && (defined(__x86_64__) || defined(_M_X64))
+    return glm::uvec2((glm::uint32)_pext_u64(code, 0x5555555555555555ull), (glm::uint32)_pext_u64(code, 0xaaaaaaaaaaaaaaaaull));
+#else
+    return glm::uvec2((glm::uint32)morton_compact_1by1(code), (glm::uint32)morton_compact_1by1(code >> 1));
+#endif
+}
+
+enum morton_kernel_2d
+{
+    MORTON_KERNEL_LOOP = 0,     // one bit pair per iteration
+    MORTON_KERNEL_TABLE,        // 256 entry byte tables
+    MORTON_KERNEL_MAGIC,        // shift and mask, as the inline functions
+    MORTON_KERNEL_BMI2          // pdep/pext
+};
+
+void morton_encode_2d(const glm::uvec2* positions, glm::uint32* codes, const size_t count);
+void morton_decode_2d(const glm::uint32* codes, glm::uvec2* positions, const size_t count);
+void morton_encode_2d(const glm::uvec2* positions, glm::uint64* codes, const size_t count);
+void morton_decode_2d(const glm::uint64* codes, glm::uvec2* positions, const size_t count);
+
+bool morton_kernel_2d_supported(const morton_kernel_2d kernel);
+const char* morton_kernel_2d_name(const morton_kernel_2d kernel);
+
+// kernel used by the batch functions, returns false if the cpu lacks it
+morton_kernel_2d active_morton_kernel_2d();
+bool set_morton_kernel_2d(const morton_kernel_2d kernel);
+
+#endif // #ifndef MORTON_2D_HPP
@@ -11,28 +11,52 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/norm.hpp>
 
+#include <cstddef>
+
 namespace scm {
 namespace data {
 
 namespace detail {
+
+// unsigned integer with the low n bits set
+template <typename IndexT>
+constexpr IndexT
+low_bits(unsigned n)
+{
+    return (n >= sizeof(IndexT) * 8 ? ~IndexT(0) : ((IndexT(1) << n) - 1));
+}
+
 } // namespace detail
 
 // 3 dimensional z-order (Morton) space filling curve
 // linear layout of octree
+//
+// IndexT holds the global node index of trees up to MaxDepth levels below
+// the root; the counts of all levels up to MaxDepth + 1 have to fit, which
+// is depth 15 for 32 bit and depth 31 for 64 bit indices. Node counts and
+// level offsets are constexpr.
+template <typename IndexT = glm::uint32, unsigned MaxDepth = 15>
 class quadtree_layout
 {
 public:
-    typedef glm::uint32         index_type;
+    typedef IndexT              index_type;
     typedef glm::uvec2          position_type;
     //typedef layout_z_order_tag  layout_type;
 
+    static const unsigned       max_depth = MaxDepth;
+
+    static_assert(2 * (MaxDepth + 1) <= sizeof(IndexT) * 8, "quadtree_layout: MaxDepth exceeds the index type");
+    static_assert(MaxDepth < 32, "quadtree_layout: positions are 32 bit");
+
 public:
     // counts
-    index_type                  total_node_count(unsigned depth) const;
-    index_type                  total_node_count_level(unsigned level) const;
+    static constexpr index_type total_node_count(unsigned depth);
+    static constexpr index_type total_node_count_level(unsigned level);
+    // index of the first node of a level, total_node_count(level - 1)
+    static constexpr index_type level_offset(unsigned level);
 
     // indexing
-    index_type                  root_index() const;
+    static constexpr index_type root_index();
     unsigned                    level_index(index_type node_index) const;
     index_type                  parent_node_index(index_type node_index) const;
     index_type                  child_node_index(index_type node_index,
@@ -51,8 +75,16 @@ public:
     index_type                  node_index(const position_type& node_position,
                                            unsigned             level) const;
 
+    // index -> position of many nodes, see morton_decode_2d
+    void                        node_positions(const index_type* node_indices,
+                                               position_type*    positions,
+                                               size_t            count) const;
+
 }; // class tree_layout<layout_z_order_tag, 2>
 
+// depth 18-22 trees
+typedef quadtree_layout<glm::uint64, 31> quadtree_layout_64;
+
 } // namespace data
 } // namespace scm
 
@@ -0,0 +1,59 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+// -----------------------------------------------------------------------------
+// Bounded lock-free queue between one producer and one consumer thread
+//
+// A ring of capacity + 1 slots. Only the producer moves the tail and only the
+// consumer the head, each publishing with a release store the other side
+// acquires, so neither side ever waits on the other: push fails on a full
+// queue, pop on an empty one. Values are assigned into and out of the slots,
+// vectors and the like keep their storage and stop allocating once every
+// slot has held the largest value.
+// -----------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+
+template <typename T, size_t Capacity>
+class spsc_queue
+{
+public:
+    spsc_queue() : m_head(0), m_tail(0) {}
+
+    // producer only, false if the queue is full
+    bool push(const T& value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) % (Capacity + 1);
+        if (next == m_head.load(std::memory_order_acquire))
+            return false;
+
+        m_slots[tail] = value;
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only, false if the queue is empty
+    bool pop(T& value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+
+        value = m_slots[head];
+        m_head.store((head + 1) % (Capacity + 1), std::memory_order_release);
+        return true;
+    }
+
+private:
+    spsc_queue(const spsc_queue&);
+    spsc_queue& operator=(const spsc_queue&);
+
+    T m_slots[Capacity + 1];
+
+    // apart, so the two sides do not share a cache line
+    std::atomic<size_t> m_head;
+    char m_padding[64];
+    std::atomic<size_t> m_tail;
+};
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,115 @@
+// -----------------------------------------------------------------------------
+// Fixed set of worker threads for chunked parallel loops
+// -----------------------------------------------------------------------------
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+thread_pool::thread_pool(const unsigned threads)
+: m_function(nullptr),
+m_body(nullptr),
+m_count(0),
+m_chunk(1),
+m_next_chunk(0),
+m_generation(0),
+m_busy(0),
+m_stop(false)
+{
+    unsigned count = threads ? threads : std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned w = 1; w < count; ++w){
+        m_workers.push_back(std::thread(&thread_pool::work, this, w));
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (auto& t : m_workers){
+        t.join();
+    }
+}
+
+thread_pool&
+thread_pool::shared()
+{
+    static thread_pool pool;
+    return pool;
+}
+
+void
+thread_pool::run(const size_t count, const size_t chunk, body_function function, void* body)
+{
+    if (count == 0)
+        return;
+
+    const size_t chunk_size = std::max(chunk, (size_t)1);
+
+    // nothing to share
+    if (m_workers.empty() || count <= chunk_size){
+        for (size_t begin = 0; begin < count; begin += chunk_size){
+            function(body, begin, std::min(begin + chunk_size, count), 0);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(m_run_mutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_function = function;
+        m_body = body;
+        m_count = count;
+        m_chunk = chunk_size;
+        m_next_chunk = 0;
+        m_busy = (unsigned)m_workers.size();
+        ++m_generation;
+    }
+    m_start.notify_all();
+
+    run_chunks(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]{ return m_busy == 0; });
+}
+
+void
+thread_pool::work(const unsigned worker)
+{
+    unsigned generation = 0;
+
+    for (;;){
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&]{ return m_stop || m_generation != generation; });
+            if (m_stop)
+                return;
+            generation = m_generation;
+        }
+
+        run_chunks(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_busy;
+        }
+        m_done.notify_one();
+    }
+}
+
+void
+thread_pool::run_chunks(const unsigned worker)
+{
+    const size_t chunks = (m_count + m_chunk - 1) / m_chunk;
+
+    for (size_t c = m_next_chunk++; c < chunks; c = m_next_chunk++){
+        size_t begin = c * m_chunk;
+        m_function(m_body, begin, std::min(begin + m_chunk, m_count), worker);
+    }
+}
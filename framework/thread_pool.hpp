@@ -0,0 +1,78 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+// -----------------------------------------------------------------------------
+// Fixed set of worker threads for chunked parallel loops
+//
+// parallel_for hands out the chunks of an index range to the workers and the
+// calling thread, which blocks until all of them are done. Chunks are fixed
+// by the range and the chunk size, not by the number of workers, so a loop
+// that keeps per chunk results and combines them in chunk order gives the
+// same result with any number of threads. Running a loop takes no heap
+// allocation; a pool of one thread runs it inline.
+// -----------------------------------------------------------------------------
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class thread_pool
+{
+public:
+    // 0 threads uses one per hardware thread, the caller counts as one
+    explicit thread_pool(const unsigned threads = 0);
+    ~thread_pool();
+
+    // threads taking part in a loop, the caller included. Worker ids
+    // passed to the loop body are below this.
+    unsigned size() const { return (unsigned)m_workers.size() + 1; }
+
+    // calls body(begin, end, worker) for the chunks of [0, count). Loops
+    // of several threads run one after the other, a body must not start
+    // a loop of its own.
+    template <typename Body>
+    void parallel_for(const size_t count, const size_t chunk, Body& body) {
+        run(count, chunk, &call_body<Body>, &body);
+    }
+
+    // process wide pool with one thread per hardware thread
+    static thread_pool& shared();
+
+private:
+    thread_pool(const thread_pool&);
+    thread_pool& operator=(const thread_pool&);
+
+    typedef void (*body_function)(void* body, size_t begin, size_t end, unsigned worker);
+
+    template <typename Body>
+    static void call_body(void* body, size_t begin, size_t end, unsigned worker) {
+        (*static_cast<Body*>(body))(begin, end, worker);
+    }
+
+    void run(const size_t count, const size_t chunk, body_function function, void* body);
+    void work(const unsigned worker);
+    void run_chunks(const unsigned worker);
+
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_run_mutex;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+
+    // the loop of the current generation
+    body_function m_function;
+    void* m_body;
+    size_t m_count;
+    size_t m_chunk;
+    std::atomic<size_t> m_next_chunk;
+
+    unsigned m_generation;
+    unsigned m_busy;
+    bool m_stop;
+};
+
+#endif // THREAD_POOL_HPP
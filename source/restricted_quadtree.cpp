@@ -20,8 +20,6 @@
 #include <algorithm>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
-#include <thread>
 
 ///GLM INCLUDES
 #define GLM_FORCE_RADIANS
@@ -155,7 +153,12 @@ bool      g_restriction_direction = true;
 bool      g_restriction = true;
 
 int g_splits_per_frame = 1;
-int g_sleep_miliseconds = 5;
+float g_refinement_miliseconds = 0.0f;
+float g_hysteresis_band = HYSTERESIS_BAND;
+int g_residency_frames = HYSTERESIS_RESIDENCY;
+int g_churn_frames = CHURN_FRAMES;
+int g_collapse_cache_blocks = COLLAPSE_CACHE_BLOCKS;
+bool g_ideal_solver = false;
 
 struct Manipulator
 {
@@ -488,8 +491,11 @@ void showGUI(){
         ImGui::Text(std::string("max  Budget: ").append(std::to_string(q_renderer.m_treeInfo.max_budget)).c_str());
         ImGui::Text(std::string("used Budget: ").append(std::to_string(q_renderer.m_treeInfo.used_budget)).c_str());
         ImGui::Text(std::string("used ideal Budget: ").append(std::to_string(q_renderer.m_treeInfo.used_ideal_budget)).c_str());
+        ImGui::Checkbox("follow ideal tree", &g_ideal_solver);
+        ImGui::Text(std::string("Ideal Distance: ").append(std::to_string(q_renderer.m_treeInfo.ideal_distance)).append(" age: ").append(std::to_string(q_renderer.m_treeInfo.ideal_age)).append(" solve us: ").append(std::to_string(q_renderer.m_treeInfo.time_new_tree_update)).c_str());
         ImGui::Separator();
         ImGui::Text(std::string("Global Error: ").append(std::to_string(q_renderer.m_treeInfo.global_error)).c_str());
+        ImGui::Text(std::string("Forced Splits: ").append(std::to_string(q_renderer.m_treeInfo.forced_splits)).append(" max per split: ").append(std::to_string(q_renderer.m_treeInfo.max_forced_splits)).c_str());
         ImGui::Separator();
         ImGui::Text(std::string("Min Prio: ").append(std::to_string(q_renderer.m_treeInfo.min_prio)).c_str());
 		ImGui::SameLine();
@@ -509,7 +515,15 @@ void showGUI(){
         ImGui::Separator();
 
 		ImGui::SliderInt("Splits per Frame", &g_splits_per_frame, 0, 100);
-		ImGui::SliderInt("Frame Delay Miliseconds", &g_sleep_miliseconds, 0, 200);
+		ImGui::SliderFloat("Refinement Budget Miliseconds", &g_refinement_miliseconds, 0.0f, 20.0f);
+		ImGui::SliderFloat("Hysteresis Band", &g_hysteresis_band, 0.0f, 0.5f);
+		ImGui::SliderInt("Residency Frames", &g_residency_frames, 0, 60);
+		ImGui::SliderInt("Churn Frames", &g_churn_frames, 1, 120);
+		ImGui::Text(std::string("Churned Splits: ").append(std::to_string(q_renderer.m_treeInfo.churned_splits)).c_str());
+		ImGui::SliderInt("Collapse Cache Blocks", &g_collapse_cache_blocks, 0, 4096);
+		ImGui::Text(std::string("Collapse Cache Hits: ").append(std::to_string(q_renderer.m_treeInfo.collapse_cache_hits)).append(" misses: ").append(std::to_string(q_renderer.m_treeInfo.collapse_cache_misses)).append(" blocks: ").append(std::to_string(q_renderer.m_treeInfo.collapse_cache_blocks)).c_str());
+		ImGui::Text(std::string("Pending Plan Steps: ").append(std::to_string(q_renderer.m_treeInfo.pending_plan_steps)).append(" deferred evaluations: ").append(std::to_string(q_renderer.m_treeInfo.deferred_evaluations)).c_str());
+		ImGui::Text(std::string("Update Lag Frames: ").append(std::to_string(q_renderer.get_update_lag())).c_str());
 
     }
 
@@ -640,6 +654,11 @@ int main(int argc, char* argv[])
 		
 		q_renderer.set_test_point(g_test_point);
 		q_renderer.set_splits_per_frame(g_splits_per_frame);
+		q_renderer.set_frame_time_budget(g_refinement_miliseconds);
+		q_renderer.set_hysteresis(g_hysteresis_band, g_residency_frames);
+		q_renderer.set_churn_frames(g_churn_frames);
+		q_renderer.set_collapse_cache(g_collapse_cache_blocks);
+		q_renderer.set_ideal_solver(g_ideal_solver);
 
         /// reload shader if key R ist pressed
         if (g_reload_shader){
@@ -767,9 +786,6 @@ int main(int argc, char* argv[])
 
         glBindTexture(GL_TEXTURE_2D, 0);
         g_win.update();
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(g_sleep_miliseconds));
-
     }
 
     //IMGUI shutdown
@@ -0,0 +1,69 @@
+#include <UnitTest++.h>
+
+#include "engine_fixtures.hpp"
+
+SUITE(collapse_cache)
+{
+    TEST(evicts_least_recently_collapsed)
+    {
+        node_set set(6);
+        auto n = set.nodes.data();
+        auto block = set.nodes.data() + 3;
+
+        QuadtreeEngine::q_collapse_cache cache;
+        cache.reserve(2);
+        CHECK_EQUAL(2u, cache.capacity());
+        CHECK(cache.oldest() == nullptr);
+
+        cache.push(n[0], block[0]);
+        cache.push(n[1], block[1]);
+        CHECK(cache.full());
+        CHECK_EQUAL(n[0], cache.oldest());
+        CHECK_EQUAL(block[1], cache.block(n[1]));
+
+        // evicting the oldest makes room for the next collapse
+        CHECK_EQUAL(block[0], cache.take(cache.oldest()));
+        CHECK(!cache.contains(n[0]));
+        cache.push(n[2], block[2]);
+        CHECK_EQUAL(n[1], cache.oldest());
+
+        // a re-split takes an entry out of the middle of the order, the
+        // node collapsed again is the newest
+        CHECK_EQUAL(block[1], cache.take(n[1]));
+        cache.push(n[1], block[1]);
+        CHECK_EQUAL(n[2], cache.oldest());
+        CHECK_EQUAL(block[2], cache.take(cache.oldest()));
+        CHECK_EQUAL(n[1], cache.oldest());
+        CHECK_EQUAL(block[1], cache.take(cache.oldest()));
+
+        CHECK_EQUAL(0u, cache.size());
+        CHECK(cache.oldest() == nullptr);
+        CHECK(cache.block(n[1]) == nullptr);
+    }
+
+    TEST(resplit_builds_the_same_tree)
+    {
+        // the same views with and without cached blocks
+        QuadtreeEngine uncached(600, 7);
+        QuadtreeEngine cached(600, 7);
+        uncached.set_thread_pool(nullptr);
+        cached.set_thread_pool(nullptr);
+        uncached.set_collapse_cache(0);
+        cached.set_collapse_cache(200);
+        uncached.set_splits_per_frame(20);
+        cached.set_splits_per_frame(20);
+
+        unsigned hits = 0;
+        unsigned different = 0;
+        for (unsigned f = 0; f != 300; ++f){
+            auto views = circling_views(std::sin(f * 0.05f) * 2.0f);
+            uncached.update(views);
+            hits += cached.update(views).collapse_cache_hits;
+            different += leaf_ids(uncached) != leaf_ids(cached) ? 1 : 0;
+        }
+
+        // a re-split from the cache links the children it had before
+        CHECK(hits > 0);
+        CHECK_EQUAL(0u, different);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef ENGINE_FIXTURES_HPP
+#define ENGINE_FIXTURES_HPP
+
+#include <QuadtreeEngine.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// nodes of a pool, as the engine allocates them
+struct node_set{
+    QuadtreeEngine::q_node_pool pool;
+    std::vector<QuadtreeEngine::q_node_ptr> nodes;
+
+    explicit node_set(const size_t count){
+        pool.reserve((count + CHILDREN - 1) / CHILDREN);
+        while (nodes.size() < count){
+            auto block = pool.allocate_block();
+            for (unsigned c = 0; c != CHILDREN && nodes.size() < count; ++c){
+                nodes.push_back(block + c);
+            }
+        }
+    }
+};
+
+// one view circling the center of the tree, looking inwards
+inline std::vector<QuadtreeEngine::frustrum_2d>
+circling_views(const float t)
+{
+    std::vector<QuadtreeEngine::frustrum_2d> views(1);
+    views[0].m_camera_point = glm::vec2(0.5f + 0.4f * std::sin(t), 0.5f + 0.4f * std::cos(t));
+    views[0].m_frustrum_points[0] = glm::vec2(0.5f + 0.2f * std::sin(t + 0.5f), 0.5f + 0.2f * std::cos(t + 0.5f));
+    views[0].m_frustrum_points[1] = glm::vec2(0.5f + 0.2f * std::sin(t - 0.5f), 0.5f + 0.2f * std::cos(t - 0.5f));
+    return views;
+}
+
+// ids of the leafs of the current tree, in order
+inline std::vector<QuadtreeEngine::index_type>
+leaf_ids(const QuadtreeEngine& engine)
+{
+    std::vector<QuadtreeEngine::index_type> ids;
+    for (auto l : engine.get_leaf_nodes()){
+        ids.push_back(l->node_id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// pairs of cells of the finest level next to each other whose leafs
+// differ by more than one level, and cells no leaf covers
+inline unsigned
+restriction_violations(const QuadtreeEngine& engine, const unsigned max_depth)
+{
+    const unsigned side = 1u << max_depth;
+    std::vector<int> depth(side * side, -1);
+
+    for (auto l : engine.get_leaf_nodes()){
+        auto position = engine.get_layout().node_position(l->node_id);
+        unsigned size = 1u << (max_depth - l->depth);
+        for (unsigned y = position.y * size; y != (position.y + 1) * size; ++y){
+            for (unsigned x = position.x * size; x != (position.x + 1) * size; ++x){
+                depth[y * side + x] = (int)l->depth;
+            }
+        }
+    }
+
+    unsigned violations = 0;
+    for (unsigned y = 0; y != side; ++y){
+        for (unsigned x = 0; x != side; ++x){
+            int d = depth[y * side + x];
+            violations += d < 0 ? 1 : 0;
+            violations += x + 1 != side && std::abs(d - depth[y * side + x + 1]) > 1 ? 1 : 0;
+            violations += y + 1 != side && std::abs(d - depth[(y + 1) * side + x]) > 1 ? 1 : 0;
+        }
+    }
+    return violations;
+}
+
+#endif // ENGINE_FIXTURES_HPP
@@ -0,0 +1,78 @@
+#include <UnitTest++.h>
+
+#include "engine_fixtures.hpp"
+
+#include <epoch_reclaim.hpp>
+
+#include <algorithm>
+
+SUITE(epoch_reclaim)
+{
+    TEST(open_section_holds_back_its_epoch)
+    {
+        epoch_domain epochs;
+        CHECK_EQUAL(epochs.epoch() + 1, epochs.safe_epoch());
+
+        auto slot = epochs.enter();
+        const auto retired = epochs.epoch();
+
+        // later updates do not free what the section may reach
+        epochs.advance();
+        epochs.advance();
+        CHECK(epochs.safe_epoch() <= retired);
+
+        // a section begun later only holds back its own epoch
+        auto later = epochs.enter();
+        epochs.leave(slot);
+        CHECK(epochs.safe_epoch() > retired);
+        CHECK_EQUAL(epochs.epoch(), epochs.safe_epoch());
+
+        epochs.leave(later);
+        CHECK_EQUAL(epochs.epoch() + 1, epochs.safe_epoch());
+    }
+
+    TEST(sections_take_separate_slots)
+    {
+        epoch_domain epochs;
+        std::vector<unsigned> slots;
+        for (unsigned s = 0; s != EPOCH_READER_SLOTS; ++s){
+            slots.push_back(epochs.enter());
+        }
+        for (unsigned s = 0; s != slots.size(); ++s){
+            for (unsigned t = 0; t != s; ++t){
+                CHECK(slots[s] != slots[t]);
+            }
+        }
+        for (auto s : slots){
+            epochs.leave(s);
+        }
+    }
+
+    TEST(engine_retires_blocks_behind_read_section)
+    {
+        QuadtreeEngine engine(2000, 7);
+        engine.set_thread_pool(nullptr);
+        engine.set_collapse_cache(0);
+        engine.set_splits_per_frame(50);
+        engine.split_to_depth(5);
+
+        size_t held_back = 0;
+        {
+            QuadtreeEngine::read_section section(engine);
+            auto root = section.root();
+
+            for (unsigned f = 0; f != 40; ++f){
+                held_back = std::max(held_back, engine.update(circling_views(f * 0.2f)).retired_blocks);
+            }
+
+            // unlinked blocks wait for the section, the tree stays readable
+            CHECK(held_back > 0);
+            CHECK_EQUAL(root, section.root());
+            unsigned depth;
+            CHECK(section.find_leaf(glm::uvec2(0, 0), depth) != nullptr);
+        }
+
+        // the next update frees them, and those it unlinks itself
+        CHECK_EQUAL(0u, engine.update(circling_views(40 * 0.2f)).retired_blocks);
+    }
+}
@@ -0,0 +1,43 @@
+#include <UnitTest++.h>
+
+#include "engine_fixtures.hpp"
+
+namespace {
+
+// churned splits of an engine settled on one view and then flipped
+// between two views every update
+unsigned
+flipping_churn(const float band, const unsigned residency_frames)
+{
+    QuadtreeEngine engine(600, 7);
+    engine.set_thread_pool(nullptr);
+    engine.set_splits_per_frame(20);
+    engine.set_hysteresis(band, residency_frames);
+    engine.set_churn_frames(8);
+
+    for (unsigned f = 0; f != 60; ++f){
+        engine.update(circling_views(0.0f));
+    }
+
+    unsigned churn = 0;
+    for (unsigned f = 0; f != 200; ++f){
+        churn += engine.update(circling_views((f % 2) * 0.3f)).churned_splits;
+    }
+    return churn;
+}
+
+}
+
+SUITE(hysteresis)
+{
+    TEST(flipping_views_churn_without_hysteresis)
+    {
+        CHECK(flipping_churn(0.0f, 0) > 0);
+    }
+
+    TEST(residency_stops_the_churn)
+    {
+        // nothing split within the churn frames may collapse again
+        CHECK_EQUAL(0u, flipping_churn(0.1f, 8));
+    }
+}
@@ -0,0 +1,32 @@
+#include <UnitTest++.h>
+
+#include "engine_fixtures.hpp"
+
+#include <chrono>
+#include <thread>
+
+SUITE(ideal_solver)
+{
+    TEST(current_tree_reaches_the_ideal_one)
+    {
+        QuadtreeEngine engine(3000, 8);
+        engine.set_thread_pool(nullptr);
+        engine.set_splits_per_frame(50);
+        engine.set_ideal_solver(true);
+        CHECK(engine.get_ideal_solver());
+
+        // with the views held still the solver catches up and the updates
+        // exchange the current tree for the ideal one
+        bool reached = false;
+        for (unsigned f = 0; f != 2000 && !reached; ++f){
+            auto info = engine.update(circling_views(1.0f));
+            reached = f > 5 && info.ideal_age == 0 && info.ideal_distance == 0;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(reached);
+        CHECK_EQUAL(0u, restriction_violations(engine, 8));
+
+        engine.set_ideal_solver(false);
+        CHECK(!engine.get_ideal_solver());
+    }
+}
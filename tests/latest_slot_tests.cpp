@@ -0,0 +1,59 @@
+#include <UnitTest++.h>
+
+#include <latest_slot.hpp>
+
+#include <thread>
+#include <vector>
+
+SUITE(latest_slot)
+{
+    TEST(newest_value_replaces_untaken)
+    {
+        latest_slot<int> slot;
+        int value = 0;
+        CHECK(!slot.take(value));
+
+        // the first value of a round finds the slot taken
+        for (int round = 0; round != 5; ++round){
+            CHECK(slot.publish(round * 10 + 1));
+            CHECK(!slot.publish(round * 10 + 2));
+            CHECK(!slot.publish(round * 10 + 3));
+
+            CHECK(slot.take(value));
+            CHECK_EQUAL(round * 10 + 3, value);
+            CHECK(!slot.take(value));
+        }
+    }
+
+    TEST(two_threads_never_go_back)
+    {
+        const unsigned count = 200000;
+        latest_slot<std::vector<unsigned> > slot;
+
+        std::thread producer([&slot, count]{
+            for (unsigned i = 1; i <= count; ++i){
+                slot.publish(std::vector<unsigned>(i % 64 + 1, i));
+            }
+        });
+
+        // every value is whole and newer than the one before
+        unsigned last = 0;
+        unsigned torn = 0;
+        unsigned backwards = 0;
+        std::vector<unsigned> value;
+        while (last != count){
+            if (!slot.take(value)){
+                std::this_thread::yield();
+                continue;
+            }
+            torn += value.size() != value[0] % 64 + 1 || value.back() != value[0] ? 1 : 0;
+            backwards += value[0] <= last ? 1 : 0;
+            last = value[0];
+        }
+        producer.join();
+
+        CHECK_EQUAL(0u, torn);
+        CHECK_EQUAL(0u, backwards);
+        CHECK(!slot.take(value));
+    }
+}
@@ -0,0 +1,111 @@
+#include <UnitTest++.h>
+
+#include "engine_fixtures.hpp"
+
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace {
+
+typedef QuadtreeEngine::index_type index_type;
+
+// bucket of an id in a q_leaf_table of 16 entries
+size_t
+home_bucket_16(const index_type node_id)
+{
+    return (size_t)(((glm::uint64)node_id * 0x9e3779b97f4a7c15ull) >> 60);
+}
+
+}
+
+SUITE(leaf_table)
+{
+    TEST(wraparound_cluster)
+    {
+        // ids that all hash to the last bucket, the cluster wraps to the
+        // front of the table, and ids of the first bucket behind them
+        std::vector<index_type> ids;
+        for (index_type id = 1; ids.size() != 5; ++id){
+            if (home_bucket_16(id) == 15)
+                ids.push_back(id);
+        }
+        for (index_type id = 1; ids.size() != 7; ++id){
+            if (home_bucket_16(id) == 0)
+                ids.push_back(id);
+        }
+
+        node_set set(ids.size());
+        QuadtreeEngine::q_leaf_table table;
+        table.reserve(ids.size());
+        CHECK_EQUAL(16u, table.capacity());
+
+        for (size_t i = 0; i != ids.size(); ++i){
+            set.nodes[i]->node_id = ids[i];
+            table.insert(set.nodes[i]);
+        }
+        CHECK_EQUAL(ids.size(), table.size());
+        for (size_t i = 0; i != ids.size(); ++i){
+            CHECK_EQUAL(set.nodes[i], table.find(ids[i]));
+        }
+
+        // the head of the cluster, the entries behind it shift back across
+        // the end of the table
+        table.erase(set.nodes[0]);
+        CHECK(table.find(ids[0]) == nullptr);
+        for (size_t i = 1; i != ids.size(); ++i){
+            CHECK_EQUAL(set.nodes[i], table.find(ids[i]));
+        }
+
+        // an entry in the wrapped part, then one at its own bucket
+        table.erase(set.nodes[3]);
+        table.erase(set.nodes[5]);
+        CHECK_EQUAL(ids.size() - 3, table.size());
+        for (size_t i = 0; i != ids.size(); ++i){
+            bool erased = i == 0 || i == 3 || i == 5;
+            CHECK_EQUAL(erased ? nullptr : set.nodes[i], table.find(ids[i]));
+        }
+
+        // back in, the holes are reused
+        table.insert(set.nodes[0]);
+        table.insert(set.nodes[3]);
+        table.insert(set.nodes[5]);
+        CHECK_EQUAL(ids.size(), table.size());
+        CHECK_EQUAL(16u, table.capacity());
+        for (size_t i = 0; i != ids.size(); ++i){
+            CHECK_EQUAL(set.nodes[i], table.find(ids[i]));
+        }
+    }
+
+    TEST(insert_erase_against_set)
+    {
+        const size_t count = 2000;
+        node_set set(count);
+        for (size_t i = 0; i != count; ++i){
+            set.nodes[i]->node_id = (index_type)(i * 7 + 3);
+        }
+
+        // starts small, the inserts rehash a few times
+        QuadtreeEngine::q_leaf_table table;
+        std::set<size_t> inserted;
+        std::srand(42);
+        for (unsigned step = 0; step != 20000; ++step){
+            size_t i = (size_t)std::rand() % count;
+            if (inserted.count(i)){
+                table.erase(set.nodes[i]);
+                inserted.erase(i);
+            }
+            else {
+                table.insert(set.nodes[i]);
+                inserted.insert(i);
+            }
+        }
+
+        CHECK_EQUAL(inserted.size(), table.size());
+        for (size_t i = 0; i != count; ++i){
+            auto n = table.find(set.nodes[i]->node_id);
+            CHECK_EQUAL(inserted.count(i) ? set.nodes[i] : nullptr, n);
+        }
+        CHECK(table.find(1) == nullptr);
+    }
+}
@@ -0,0 +1,62 @@
+#include <UnitTest++.h>
+
+#include "engine_fixtures.hpp"
+
+SUITE(node_heap)
+{
+    TEST(pop_order_after_update_and_erase)
+    {
+        const float priorities[] = { 0.5f, 3.0f, 1.0f, 7.0f, 2.0f, 6.0f, 4.0f, 0.0f, 5.0f };
+        const size_t count = sizeof(priorities) / sizeof(priorities[0]);
+
+        node_set set(count);
+        for (size_t i = 0; i != count; ++i){
+            set.nodes[i]->priority = priorities[i];
+        }
+
+        QuadtreeEngine::q_node_heap heap;
+        heap.build(set.nodes.data(), count);
+        CHECK_EQUAL(count, heap.size());
+        CHECK_EQUAL(set.nodes[3], heap.top());
+
+        // up, down and out of the middle
+        set.nodes[7]->priority = 10.0f;
+        heap.update(set.nodes[7]);
+        set.nodes[3]->priority = 1.5f;
+        heap.update(set.nodes[3]);
+        heap.erase(set.nodes[5]);
+        CHECK(!heap.contains(set.nodes[5]));
+
+        const size_t expected[] = { 7, 8, 6, 1, 4, 3, 2, 0 };
+        for (auto e : expected){
+            CHECK(!heap.empty());
+            CHECK_EQUAL(set.nodes[e], heap.pop());
+            CHECK(!heap.contains(set.nodes[e]));
+        }
+        CHECK(heap.empty());
+    }
+
+    TEST(min_heap_push_and_clear)
+    {
+        node_set set(6);
+        QuadtreeEngine::q_node_heap heap(&QuadtreeEngine::q_node::collapsible_index, true);
+        for (size_t i = 0; i != set.nodes.size(); ++i){
+            set.nodes[i]->priority = (float)((i * 5) % 6);
+            heap.push(set.nodes[i]);
+        }
+
+        // the heap index is left alone
+        for (auto n : set.nodes){
+            CHECK(n->heap_index == QuadtreeEngine::q_node::invalid_index);
+        }
+
+        CHECK_EQUAL(0.0f, heap.pop()->priority);
+        CHECK_EQUAL(1.0f, heap.pop()->priority);
+
+        heap.clear();
+        CHECK(heap.empty());
+        for (auto n : set.nodes){
+            CHECK(!heap.contains(n));
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#include <UnitTest++.h>
+
+#include "engine_fixtures.hpp"
+
+#include <thread_pool.hpp>
+
+SUITE(parallel_apply)
+{
+    TEST(same_leafs_as_serial)
+    {
+        thread_pool pool(4);
+
+        // the same views applied by one thread and by the pool
+        QuadtreeEngine serial(5000, 9);
+        QuadtreeEngine parallel(5000, 9);
+        serial.set_thread_pool(nullptr);
+        parallel.set_thread_pool(&pool);
+        serial.set_splits_per_frame(100);
+        parallel.set_splits_per_frame(100);
+
+        unsigned max_sets = 0;
+        unsigned different = 0;
+        for (unsigned f = 0; f != 200; ++f){
+            auto views = circling_views(f * 0.05f);
+            serial.update(views);
+            max_sets = std::max(max_sets, parallel.update(views).split_sets);
+            different += leaf_ids(serial) != leaf_ids(parallel) ? 1 : 0;
+        }
+
+        // the splits came in more than one independent set
+        CHECK(max_sets > 1);
+        CHECK_EQUAL(0u, different);
+    }
+}
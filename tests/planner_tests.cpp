@@ -0,0 +1,38 @@
+#include <UnitTest++.h>
+
+#include "engine_fixtures.hpp"
+
+SUITE(planner)
+{
+    TEST(frame_budget_counts_requests_not_closures)
+    {
+        QuadtreeEngine engine(3000, 8);
+        engine.set_thread_pool(nullptr);
+        engine.set_splits_per_frame(10);
+
+        unsigned bad_frames = 0;
+        unsigned full_frames = 0;
+        unsigned closure_frames = 0;
+        for (unsigned f = 0; f != 200; ++f){
+            auto info = engine.update(circling_views(f * 0.05f));
+
+            // each requested split brings its closure, the forced splits
+            // are counted apart from the requests
+            const unsigned requests = info.planned_splits - info.forced_splits;
+            bool bad = info.forced_splits > info.planned_splits
+                || info.max_forced_splits > info.forced_splits
+                || requests > 10
+                || info.applied_splits > info.planned_splits
+                || info.used_budget > info.max_budget;
+            bad_frames += bad ? 1 : 0;
+
+            full_frames += requests == 10 ? 1 : 0;
+            closure_frames += info.planned_splits > 10 ? 1 : 0;
+        }
+
+        CHECK_EQUAL(0u, bad_frames);
+        // the view keeps moving, every frame takes all the requests it may
+        CHECK_EQUAL(200u, full_frames);
+        CHECK(closure_frames > 0);
+    }
+}
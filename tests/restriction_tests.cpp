@@ -0,0 +1,34 @@
+#include <UnitTest++.h>
+
+#include "engine_fixtures.hpp"
+
+#include <algorithm>
+
+SUITE(restriction)
+{
+    TEST(two_to_one_after_planned_exchanges)
+    {
+        // a small budget, once it is used up every split is paid for by
+        // collapses planned in the same frame
+        QuadtreeEngine engine(600, 7);
+        engine.set_thread_pool(nullptr);
+        engine.set_splits_per_frame(20);
+
+        unsigned violations = 0;
+        unsigned exchanged_splits = 0;
+        unsigned max_forced_splits = 0;
+        for (unsigned f = 0; f != 300; ++f){
+            auto info = engine.update(circling_views(f * 0.05f));
+            violations += restriction_violations(engine, 7);
+
+            if (info.used_budget + CHILDREN > info.max_budget)
+                exchanged_splits += info.applied_splits;
+            max_forced_splits = std::max(max_forced_splits, info.max_forced_splits);
+        }
+
+        CHECK_EQUAL(0u, violations);
+        CHECK(exchanged_splits > 0);
+        // forced splits that forced splits of their own
+        CHECK(max_forced_splits > 1);
+    }
+}
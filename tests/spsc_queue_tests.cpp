@@ -0,0 +1,78 @@
+#include <UnitTest++.h>
+
+#include <spsc_queue.hpp>
+
+#include <thread>
+#include <vector>
+
+SUITE(spsc_queue)
+{
+    TEST(fifo_up_to_capacity)
+    {
+        spsc_queue<int, 3> queue;
+        int value = 0;
+        CHECK(!queue.pop(value));
+
+        // several times around the ring
+        for (int round = 0; round != 5; ++round){
+            CHECK(queue.push(round * 10 + 1));
+            CHECK(queue.push(round * 10 + 2));
+            CHECK(queue.push(round * 10 + 3));
+            CHECK(!queue.push(-1));
+
+            CHECK(queue.pop(value));
+            CHECK_EQUAL(round * 10 + 1, value);
+            CHECK(queue.push(round * 10 + 4));
+
+            for (int i = 2; i != 5; ++i){
+                CHECK(queue.pop(value));
+                CHECK_EQUAL(round * 10 + i, value);
+            }
+            CHECK(!queue.pop(value));
+        }
+    }
+
+    TEST(values_keep_their_storage)
+    {
+        spsc_queue<std::vector<int>, 2> queue;
+        std::vector<int> value(100, 7);
+        CHECK(queue.push(value));
+
+        std::vector<int> out;
+        CHECK(queue.pop(out));
+        CHECK_EQUAL(100u, out.size());
+        CHECK_EQUAL(7, out[99]);
+    }
+
+    TEST(two_threads_in_order)
+    {
+        const unsigned count = 200000;
+        spsc_queue<unsigned, 4> queue;
+
+        std::thread producer([&queue, count]{
+            for (unsigned i = 0; i != count; ){
+                if (queue.push(i))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+        });
+
+        unsigned expected = 0;
+        unsigned out_of_order = 0;
+        while (expected != count){
+            unsigned value;
+            if (!queue.pop(value)){
+                std::this_thread::yield();
+                continue;
+            }
+            out_of_order += value != expected ? 1 : 0;
+            ++expected;
+        }
+        producer.join();
+
+        CHECK_EQUAL(0u, out_of_order);
+        unsigned value;
+        CHECK(!queue.pop(value));
+    }
+}
@@ -0,0 +1,42 @@
+#include <UnitTest++.h>
+
+#include "engine_fixtures.hpp"
+
+#include <algorithm>
+
+SUITE(time_slicing)
+{
+    TEST(plan_resumes_across_frames)
+    {
+        // the same views for both, one refines by the splits per frame
+        // only, the other gets a deadline every update passes at once
+        QuadtreeEngine serial(5000, 9);
+        QuadtreeEngine sliced(5000, 9);
+        serial.set_thread_pool(nullptr);
+        sliced.set_thread_pool(nullptr);
+        serial.set_splits_per_frame(100);
+        sliced.set_splits_per_frame(100);
+        sliced.set_frame_time_budget(0.001f);
+
+        unsigned pending_frames = 0;
+        unsigned violations = 0;
+        for (unsigned f = 0; f != 500; ++f){
+            auto views = circling_views(1.0f);
+            serial.update(views);
+            auto info = sliced.update(views);
+
+            // the plan steps left over are applied by the next updates,
+            // checked again against the tree they find
+            pending_frames += info.pending_plan_steps != 0 ? 1 : 0;
+            violations += restriction_violations(sliced, 9);
+        }
+
+        CHECK(pending_frames > 0);
+        CHECK_EQUAL(0u, violations);
+
+        // once the plans are done both trees are the same
+        CHECK_EQUAL(0u, sliced.get_tree_info().pending_plan_steps);
+        CHECK_EQUAL(0u, sliced.get_tree_info().deferred_evaluations);
+        CHECK(leaf_ids(serial) == leaf_ids(sliced));
+    }
+}